@@ -0,0 +1,55 @@
+// Copyright 2019-2021 Rexocrates. All Rights Reserved.
+
+#include "VertexAnimBoneAsset.h"
+
+#include "Animation/Skeleton.h"
+
+
+bool UVertexAnimBoneAsset::HoldsClips(const USkeleton* InSkeleton, const TArray <FVASequenceData>& InAnims, const FIntPoint& InSize) const
+{
+	// Deduplicated frames need fewer rows than the layout of the profile
+	if ((Skeleton == NULL) || (Skeleton != InSkeleton) || (Size_Bone.X != InSize.X) || (Size_Bone.Y > InSize.Y)) return false;
+	if ((BonePosTexture == NULL) || (BoneRotTexture == NULL) || !BonePosData_CPU.IsValid() || !BoneRotData_CPU.IsValid()) return false;
+	if (Anims_Bone.Num() != InAnims.Num()) return false;
+
+	for (int32 i = 0; i < InAnims.Num(); i++)
+	{
+		if ((Anims_Bone[i].SequenceRef != InAnims[i].SequenceRef) || (Anims_Bone[i].NumFrames != InAnims[i].NumFrames)) return false;
+	}
+
+	return true;
+}
+
+void UVertexAnimBoneAsset::CopyToProfile(UVertexAnimProfile* Profile) const
+{
+	for (int32 i = 0; i < Profile->Anims_Bone.Num(); i++)
+	{
+		Profile->Anims_Bone[i].AnimStart_Generated = Anims_Bone[i].AnimStart_Generated;
+		Profile->Anims_Bone[i].FrameRows_Generated = Anims_Bone[i].FrameRows_Generated;
+		Profile->Anims_Bone[i].Speed_Generated = Anims_Bone[i].Speed_Generated;
+	}
+
+	Profile->OverrideSize_Bone = Size_Bone;
+	Profile->MaxValuePosition_Bone = MaxValuePosition_Bone;
+	Profile->BonePosTexture = BonePosTexture;
+	Profile->BoneRotTexture = BoneRotTexture;
+	Profile->FrameRowTexture_Bone = FrameRowTexture_Bone;
+	Profile->BoneNames_Generated = BoneNames_Generated;
+	Profile->BonePosData_CPU = BonePosData_CPU;
+	Profile->BoneRotData_CPU = BoneRotData_CPU;
+	Profile->CacheBoneQueryData();
+}
+
+void UVertexAnimBoneAsset::CopyFromProfile(const UVertexAnimProfile* Profile, USkeleton* InSkeleton)
+{
+	Skeleton = InSkeleton;
+	Anims_Bone = Profile->Anims_Bone;
+	Size_Bone = Profile->OverrideSize_Bone;
+	MaxValuePosition_Bone = Profile->MaxValuePosition_Bone;
+	BonePosTexture = Profile->BonePosTexture;
+	BoneRotTexture = Profile->BoneRotTexture;
+	FrameRowTexture_Bone = Profile->FrameRowTexture_Bone;
+	BoneNames_Generated = Profile->BoneNames_Generated;
+	BonePosData_CPU = Profile->BonePosData_CPU;
+	BoneRotData_CPU = Profile->BoneRotData_CPU;
+}
@@ -0,0 +1,500 @@
+// Copyright 2019-2021 Rexocrates. All Rights Reserved.
+
+#include "VertexAnimDecoder.h"
+
+#include "VertexAnimProfile.h"
+
+#include "Engine/Texture2D.h"
+#include "Async/ParallelFor.h"
+#include "Math/VectorRegister.h"
+
+
+// Queries handled per worker task in the batch functions
+static const int32 DecodeBatchSize = 1024;
+
+
+void FVATextureData::Init(const int32 InWidth, const int32 InHeight, const TArray<FFloat16Color>& Data, const int32 SrcWidth)
+{
+	const int32 Pitch = SrcWidth > 0 ? SrcWidth : InWidth;
+	check(Pitch >= InWidth);
+	check(Data.Num() >= Pitch * InHeight);
+
+	Width = InWidth;
+	Height = InHeight;
+	Texels.SetNumUninitialized(Width * Height * 4);
+
+	for (int32 Y = 0; Y < Height; Y++)
+	{
+		FMemory::Memcpy(&Texels[Y * Width * 4], &Data[Y * Pitch], Width * sizeof(FFloat16Color));
+	}
+}
+
+#if WITH_EDITORONLY_DATA
+bool FVATextureData::InitFromTexture(UTexture2D* Texture)
+{
+	if ((Texture == NULL) || ((Texture->Source.GetFormat() != TSF_RGBA16F) && (Texture->Source.GetFormat() != TSF_G16))) return false;
+
+	Width = Texture->Source.GetSizeX();
+	Height = Texture->Source.GetSizeY();
+	Texels.SetNumZeroed(Width * Height * 4);
+
+	const uint8* TextureData = Texture->Source.LockMip(0);
+	if (Texture->Source.GetFormat() == TSF_G16)
+	{
+		const uint16* Src = (const uint16*)TextureData;
+		for (int32 i = 0; i < Width * Height; i++)
+		{
+			Texels[i * 4] = Src[i];
+		}
+	}
+	else
+	{
+		FMemory::Memcpy(Texels.GetData(), TextureData, Texels.Num() * sizeof(uint16));
+	}
+	Texture->Source.UnlockMip(0);
+
+	return true;
+}
+#endif
+
+
+FVector FVertexAnimDecoder::DecodeVector(const FLinearColor& Texel, const float Bound)
+{
+	// RGB in 0 - 1 normalized by the biggest component, A holds that component relative to Bound
+	return ((FVector(Texel.R, Texel.G, Texel.B) * 2.f) - 1.f) * Texel.A * Bound;
+}
+
+FVector FVertexAnimDecoder::DecodeVectorHDR(const FLinearColor& Texel, const float Bound)
+{
+	// RGB in -1 - 1 normalized by the biggest component, A holds that component in -1 - 1 relative to Bound
+	const float MaxDim = (Texel.A + 1.f) * 0.5f * Bound;
+	return FVector(Texel.R, Texel.G, Texel.B) * MaxDim;
+}
+
+FQuat FVertexAnimDecoder::DecodeQuat(const FLinearColor& Texel)
+{
+	// Quats whose 3 smallest components are all 0 are baked as (0, 0, 0, 1)
+	if ((Texel.R == 0.f) && (Texel.G == 0.f))
+	{
+		return FQuat::Identity;
+	}
+
+	// The signs of R and G hold the index of the biggest (dropped) component
+	const bool Bit0 = Texel.R > 0.f;
+	const bool Bit1 = Texel.G > 0.f;
+	const int32 BigComp = (Bit0 ? 2 : 0) + (Bit1 ? 1 : 0);
+
+	const float MaxDim = (Texel.A + 1.f) * 0.5f;
+	const FVector Small = FVector(
+		((FMath::Abs(Texel.R) * 2.f) - 1.f) * MaxDim,
+		((FMath::Abs(Texel.G) * 2.f) - 1.f) * MaxDim,
+		Texel.B * MaxDim);
+	const float Big = FMath::Sqrt(FMath::Max(0.f, 1.f - Small.SizeSquared()));
+
+	float Comps[4];
+	int32 SmallIndex = 0;
+	for (int32 i = 0; i < 4; i++)
+	{
+		Comps[i] = (i == BigComp) ? Big : Small[SmallIndex++];
+	}
+
+	FQuat Q = FQuat(Comps[0], Comps[1], Comps[2], Comps[3]);
+	Q.Normalize();
+	return Q;
+}
+
+FVector2D FVertexAnimDecoder::EncodeOctahedral(const FVector& N)
+{
+	const FVector P = N / FMath::Max(FMath::Abs(N.X) + FMath::Abs(N.Y) + FMath::Abs(N.Z), SMALL_NUMBER);
+
+	// The lower hemisphere is folded over the diagonals
+	if (P.Z >= 0.f) return FVector2D(P.X, P.Y);
+
+	return FVector2D(
+		(1.f - FMath::Abs(P.Y)) * (P.X >= 0.f ? 1.f : -1.f),
+		(1.f - FMath::Abs(P.X)) * (P.Y >= 0.f ? 1.f : -1.f));
+}
+
+FVector FVertexAnimDecoder::DecodeOctahedral(const FVector2D& Oct)
+{
+	FVector N = FVector(Oct.X, Oct.Y, 1.f - FMath::Abs(Oct.X) - FMath::Abs(Oct.Y));
+
+	const float T = FMath::Max(-N.Z, 0.f);
+	N.X += (N.X >= 0.f) ? -T : T;
+	N.Y += (N.Y >= 0.f) ? -T : T;
+
+	return N.GetSafeNormal();
+}
+
+uint32 FVertexAnimDecoder::QuantizeOctahedral(const FVector& N, const int32 BitsPerAxis)
+{
+	const FVector2D Oct = EncodeOctahedral(N);
+	const float MaxValue = (float)((1 << BitsPerAxis) - 1);
+
+	const uint32 X = (uint32)FMath::RoundToInt(FMath::Clamp((Oct.X * 0.5f) + 0.5f, 0.f, 1.f) * MaxValue);
+	const uint32 Y = (uint32)FMath::RoundToInt(FMath::Clamp((Oct.Y * 0.5f) + 0.5f, 0.f, 1.f) * MaxValue);
+	return (X << BitsPerAxis) | Y;
+}
+
+FVector FVertexAnimDecoder::DequantizeOctahedral(const uint32 Packed, const int32 BitsPerAxis)
+{
+	const uint32 Mask = (1 << BitsPerAxis) - 1;
+	const float MaxValue = (float)Mask;
+
+	return DecodeOctahedral(FVector2D(
+		((((Packed >> BitsPerAxis) & Mask) / MaxValue) * 2.f) - 1.f,
+		(((Packed & Mask) / MaxValue) * 2.f) - 1.f));
+}
+
+FQuat FVertexAnimDecoder::EncodeQTangent(const FVector& TangentX, const FVector& TangentZ, const float BitangentSign)
+{
+	// Orthonormal frame with the normal kept exact, Y = Z x X like the engine builds the bitangent
+	const FVector Z = TangentZ.GetSafeNormal();
+	FVector X = (TangentX - (Z * (Z | TangentX))).GetSafeNormal();
+	if (X.IsNearlyZero())
+	{
+		FVector Unused;
+		Z.FindBestAxisVectors(X, Unused);
+	}
+	const FVector Y = Z ^ X;
+
+	FQuat Q = FQuat(FMatrix(X, Y, Z, FVector::ZeroVector));
+	Q.Normalize();
+	if (Q.W < 0.f) Q = Q * -1.f;
+
+	// W is kept away from 0 so its sign survives half precision, the smallest W a half stores without denormals
+	const float Bias = 1.f / 16384.f;
+	if (Q.W < Bias)
+	{
+		const float Scale = FMath::Sqrt(1.f - (Bias * Bias));
+		Q = FQuat(Q.X * Scale, Q.Y * Scale, Q.Z * Scale, Bias);
+	}
+
+	return (BitangentSign < 0.f) ? Q * -1.f : Q;
+}
+
+void FVertexAnimDecoder::DecodeQTangent(const FLinearColor& Texel, FVector& OutTangentX, FVector& OutTangentY, FVector& OutTangentZ)
+{
+	const float Sign = (Texel.A < 0.f) ? -1.f : 1.f;
+
+	FQuat Q = FQuat(Texel.R, Texel.G, Texel.B, Texel.A);
+	Q.Normalize();
+
+	OutTangentX = Q.GetAxisX();
+	OutTangentY = Q.GetAxisY() * Sign;
+	OutTangentZ = Q.GetAxisZ();
+}
+
+FVAFrameSample FVertexAnimDecoder::CalcFrameSample(const FVASequenceData& Anim, const float Time)
+{
+	FVAFrameSample Out;
+
+	const int32 NumFrames = FMath::Max(1, Anim.NumFrames);
+	const float Frame = FMath::Frac(Time * Anim.Speed_Generated) * NumFrames;
+
+	Out.FrameA = FMath::Clamp(FMath::FloorToInt(Frame), 0, NumFrames - 1);
+	Out.FrameB = (Out.FrameA + 1) % NumFrames;
+	Out.Alpha = FMath::Frac(Frame);
+
+	return Out;
+}
+
+int32 FVertexAnimDecoder::GridUVToVertexIndex(const FVector2D& UV, const FIntPoint& TextureSize)
+{
+	// Grid UVs point to the texel corner, round to survive half precision UVs
+	const int32 X = FMath::RoundToInt(UV.X * TextureSize.X);
+	const int32 Y = FMath::RoundToInt(UV.Y * TextureSize.Y);
+	return (Y * TextureSize.X) + X;
+}
+
+float FVertexAnimDecoder::PackIndex(const uint32 Index)
+{
+	const uint32 f16 = Index + 1024;
+	const uint32 sign = (f16 & 0x8000) << 16;
+	const uint32 expVar = (((f16 >> 10) & 0x1f) - 15 + 127) << 23;
+	const uint32 mant = (f16 & 0x3ff) << 13;
+	const uint32 f32 = sign | expVar | mant;
+
+	float Packed;
+	FMemory::Memcpy(&Packed, &f32, sizeof(float));
+	return Packed;
+}
+
+int32 FVertexAnimDecoder::UnpackIndex(const float Packed)
+{
+	uint32 uRes32;
+	FMemory::Memcpy(&uRes32, &Packed, sizeof(float));
+
+	const uint32 sign2 = (uRes32 >> 16) & 0x8000;
+	const uint32 exp2 = (((uRes32 >> 23) & 0xff) - 127 + 15) << 10;
+	const uint32 mant2 = (uRes32 >> 13) & 0x3ff;
+	return (int32)((sign2 | exp2 | mant2) - 1024);
+}
+
+int32 FVertexAnimDecoder::UVToVertexIndex(const UVertexAnimProfile* Profile, const FVector2D& UV)
+{
+	if (UV.X < 0.f) return INDEX_NONE;
+
+	return Profile->VertexIdAddressing ? UnpackIndex(UV.X) : GridUVToVertexIndex(UV, Profile->OverrideSize_Vert);
+}
+
+int32 FVertexAnimDecoder::ChannelUVToVertexIndex(const UVertexAnimProfile* Profile, const FVector2D& ChannelUV)
+{
+	return UVToVertexIndex(Profile, (Profile->UVComponent_VertAnim == 1) ? FVector2D(ChannelUV.Y, 0.f) : ChannelUV);
+}
+
+int32 FVertexAnimDecoder::CalcRow_Vert(const UVertexAnimProfile* Profile, const int32 AnimIndex, const int32 Frame)
+{
+	const FVASequenceData& Anim = Profile->Anims_Vert[AnimIndex];
+	return Anim.FrameRows_Generated.IsValidIndex(Frame) ?
+		Anim.FrameRows_Generated[Frame] : Anim.AnimStart_Generated + (Frame * Profile->RowsPerFrame_Vert);
+}
+
+int32 FVertexAnimDecoder::CalcRow_Bone(const UVertexAnimProfile* Profile, const int32 AnimIndex, const int32 Frame)
+{
+	const FVASequenceData& Anim = Profile->Anims_Bone[AnimIndex];
+	return Anim.FrameRows_Generated.IsValidIndex(Frame) ? Anim.FrameRows_Generated[Frame] : Anim.AnimStart_Generated + Frame;
+}
+
+FVector FVertexAnimDecoder::SampleVertexOffset(const UVertexAnimProfile* Profile, const FVATextureData& Offsets,
+	const int32 AnimIndex, const float Time, const int32 VertexIndex, const bool bInterpolate)
+{
+	const FVAFrameSample Sample = CalcFrameSample(Profile->Anims_Vert[AnimIndex], Time);
+	const float Bound = Profile->MaxValueOffset_Vert;
+
+	// With the normal packed in A, RGB hold the offset relative to the bound
+	const bool bNormalInOffsets = Profile->NormalEncoding == EVANormalEncoding::OctahedralInOffsets;
+	auto DecodeOffset = [Bound, bNormalInOffsets](const FLinearColor& Texel)
+	{
+		return bNormalInOffsets ? FVector(Texel.R, Texel.G, Texel.B) * Bound : DecodeVectorHDR(Texel, Bound);
+	};
+
+	const FVector A = DecodeOffset(Offsets.GetTexel((CalcRow_Vert(Profile, AnimIndex, Sample.FrameA) * Offsets.Width) + VertexIndex));
+	if (!bInterpolate) return A;
+
+	const FVector B = DecodeOffset(Offsets.GetTexel((CalcRow_Vert(Profile, AnimIndex, Sample.FrameB) * Offsets.Width) + VertexIndex));
+	return FMath::Lerp(A, B, Sample.Alpha);
+}
+
+FVector FVertexAnimDecoder::SampleVertexNormalDelta(const UVertexAnimProfile* Profile, const FVATextureData& Normals,
+	const int32 AnimIndex, const float Time, const int32 VertexIndex, const bool bInterpolate)
+{
+	const FVAFrameSample Sample = CalcFrameSample(Profile->Anims_Vert[AnimIndex], Time);
+	// Normals are baked with a fixed bound of 2
+	const float Bound = 2.f;
+
+	const FVector A = DecodeVector(Normals.GetTexel((CalcRow_Vert(Profile, AnimIndex, Sample.FrameA) * Normals.Width) + VertexIndex), Bound);
+	if (!bInterpolate) return A;
+
+	const FVector B = DecodeVector(Normals.GetTexel((CalcRow_Vert(Profile, AnimIndex, Sample.FrameB) * Normals.Width) + VertexIndex), Bound);
+	return FMath::Lerp(A, B, Sample.Alpha);
+}
+
+void FVertexAnimDecoder::SampleVertexTangentFrame(const UVertexAnimProfile* Profile, const FVATextureData& Normals,
+	const int32 AnimIndex, const float Time, const int32 VertexIndex,
+	FVector& OutTangentX, FVector& OutTangentY, FVector& OutTangentZ, const bool bInterpolate)
+{
+	const FVAFrameSample Sample = CalcFrameSample(Profile->Anims_Vert[AnimIndex], Time);
+
+	const FLinearColor A = Normals.GetTexel((CalcRow_Vert(Profile, AnimIndex, Sample.FrameA) * Normals.Width) + VertexIndex);
+	if (!bInterpolate)
+	{
+		DecodeQTangent(A, OutTangentX, OutTangentY, OutTangentZ);
+		return;
+	}
+
+	const FLinearColor B = Normals.GetTexel((CalcRow_Vert(Profile, AnimIndex, Sample.FrameB) * Normals.Width) + VertexIndex);
+
+	// The sign of W is the bitangent sign, the rotations are blended along the shortest path with it taken off
+	const float Sign = (A.A < 0.f) ? -1.f : 1.f;
+	const FQuat QA = FQuat(A.R, A.G, A.B, A.A) * Sign;
+	FQuat QB = FQuat(B.R, B.G, B.B, B.A) * ((B.A < 0.f) ? -1.f : 1.f);
+	if ((QA | QB) < 0.f) QB = QB * -1.f;
+	const FQuat Q = FQuat::FastLerp(QA, QB, Sample.Alpha).GetNormalized();
+
+	OutTangentX = Q.GetAxisX();
+	OutTangentY = Q.GetAxisY() * Sign;
+	OutTangentZ = Q.GetAxisZ();
+}
+
+FVector FVertexAnimDecoder::SampleVertexNormal(const UVertexAnimProfile* Profile, const FVATextureData& Normals,
+	const int32 AnimIndex, const float Time, const int32 VertexIndex, const bool bInterpolate)
+{
+	const FVAFrameSample Sample = CalcFrameSample(Profile->Anims_Vert[AnimIndex], Time);
+
+	auto DecodeNormal = [Profile, &Normals](const int32 Index)
+	{
+		if (Profile->NormalEncoding == EVANormalEncoding::OctahedralInOffsets)
+		{
+			return DequantizeOctahedral(UnpackIndex(Normals.GetTexel(Index).A), OctahedralBits_Offsets);
+		}
+		return DequantizeOctahedral(Normals.GetRawR(Index), OctahedralBits_Texture);
+	};
+
+	const FVector A = DecodeNormal((CalcRow_Vert(Profile, AnimIndex, Sample.FrameA) * Normals.Width) + VertexIndex);
+	if (!bInterpolate) return A;
+
+	const FVector B = DecodeNormal((CalcRow_Vert(Profile, AnimIndex, Sample.FrameB) * Normals.Width) + VertexIndex);
+	return FMath::Lerp(A, B, Sample.Alpha).GetSafeNormal();
+}
+
+FTransform FVertexAnimDecoder::MirrorTransform(const FTransform& Transform, const EAxis::Type Axis)
+{
+	FVector Translation = Transform.GetTranslation();
+	FQuat Rotation = Transform.GetRotation();
+
+	// The rotation axis is a pseudo vector, its reflection flips the components in the plane
+	switch (Axis)
+	{
+	case EAxis::X: Translation.X = -Translation.X; Rotation.Y = -Rotation.Y; Rotation.Z = -Rotation.Z; break;
+	case EAxis::Y: Translation.Y = -Translation.Y; Rotation.X = -Rotation.X; Rotation.Z = -Rotation.Z; break;
+	case EAxis::Z: Translation.Z = -Translation.Z; Rotation.X = -Rotation.X; Rotation.Y = -Rotation.Y; break;
+	default: break;
+	}
+
+	return FTransform(Rotation, Translation, Transform.GetScale3D());
+}
+
+FTransform FVertexAnimDecoder::SampleBoneTransform(const UVertexAnimProfile* Profile, const FVATextureData& BonePos, const FVATextureData& BoneRot,
+	const int32 AnimIndex, const float Time, const int32 BoneIndex, const bool bInterpolate, const bool bMirror)
+{
+	if (bMirror)
+	{
+		return MirrorTransform(SampleBoneTransform(Profile, BonePos, BoneRot, AnimIndex, Time, Profile->FindMirrorColumn(BoneIndex), bInterpolate),
+			Profile->MirrorAxis);
+	}
+
+	const FVAFrameSample Sample = CalcFrameSample(Profile->Anims_Bone[AnimIndex], Time);
+	const float Bound = Profile->MaxValuePosition_Bone;
+
+	const int32 IndexA = (CalcRow_Bone(Profile, AnimIndex, Sample.FrameA) * BonePos.Width) + BoneIndex;
+	const FVector PosA = DecodeVectorHDR(BonePos.GetTexel(IndexA), Bound);
+	const FQuat RotA = DecodeQuat(BoneRot.GetTexel(IndexA));
+	if (!bInterpolate) return FTransform(RotA, PosA);
+
+	const int32 IndexB = (CalcRow_Bone(Profile, AnimIndex, Sample.FrameB) * BonePos.Width) + BoneIndex;
+	const FVector PosB = DecodeVectorHDR(BonePos.GetTexel(IndexB), Bound);
+	const FQuat RotB = DecodeQuat(BoneRot.GetTexel(IndexB));
+
+	return FTransform(FQuat::Slerp(RotA, RotB, Sample.Alpha), FMath::Lerp(PosA, PosB, Sample.Alpha));
+}
+
+int32 FVertexAnimDecoder::CalcTexel_BoneLayer(const UVertexAnimProfile* Profile, const int32 LayerIndex, const int32 Frame, const int32 LayerColumn, const int32 Width)
+{
+	const FVABoneLayerData& Layer = Profile->Layers_Bone[LayerIndex];
+	const int32 Row = Layer.Anim.AnimStart_Generated + (Frame / Layer.FramesPerRow_Generated);
+	const int32 Column = ((Frame % Layer.FramesPerRow_Generated) * Layer.Columns_Generated.Num()) + LayerColumn;
+	return (Row * Width) + Column;
+}
+
+FTransform FVertexAnimDecoder::SampleBoneLayerTransform(const UVertexAnimProfile* Profile, const FVATextureData& BonePos, const FVATextureData& BoneRot,
+	const int32 LayerIndex, const float Time, const int32 LayerColumn, const bool bInterpolate)
+{
+	const FVAFrameSample Sample = CalcFrameSample(Profile->Layers_Bone[LayerIndex].Anim, Time);
+	const float Bound = Profile->MaxValuePosition_Bone;
+
+	const int32 IndexA = CalcTexel_BoneLayer(Profile, LayerIndex, Sample.FrameA, LayerColumn, BonePos.Width);
+	const FVector PosA = DecodeVectorHDR(BonePos.GetTexel(IndexA), Bound);
+	const FQuat RotA = DecodeQuat(BoneRot.GetTexel(IndexA));
+	if (!bInterpolate) return FTransform(RotA, PosA);
+
+	const int32 IndexB = CalcTexel_BoneLayer(Profile, LayerIndex, Sample.FrameB, LayerColumn, BonePos.Width);
+	const FVector PosB = DecodeVectorHDR(BonePos.GetTexel(IndexB), Bound);
+	const FQuat RotB = DecodeQuat(BoneRot.GetTexel(IndexB));
+
+	return FTransform(FQuat::Slerp(RotA, RotB, Sample.Alpha), FMath::Lerp(PosA, PosB, Sample.Alpha));
+}
+
+FTransform FVertexAnimDecoder::SampleLayeredBoneTransform(const UVertexAnimProfile* Profile, const FVATextureData& BonePos, const FVATextureData& BoneRot,
+	const int32 AnimIndex, const float Time, const int32 LayerIndex, const float LayerTime, const int32 BoneIndex, const bool bInterpolate)
+{
+	const FVABoneLayerData& Layer = Profile->Layers_Bone[LayerIndex];
+	const int32 LayerColumn = Layer.Columns_Generated.Find(BoneIndex);
+	if (LayerColumn == INDEX_NONE) return SampleBoneTransform(Profile, BonePos, BoneRot, AnimIndex, Time, BoneIndex, bInterpolate);
+
+	const FTransform LayerTransform = SampleBoneLayerTransform(Profile, BonePos, BoneRot, LayerIndex, LayerTime, LayerColumn, bInterpolate);
+
+	// Additive layers deform the ref pose before the anim moves it
+	if (Layer.Blend == EVALayerBlend::Additive)
+	{
+		return LayerTransform * SampleBoneTransform(Profile, BonePos, BoneRot, AnimIndex, Time, BoneIndex, bInterpolate);
+	}
+
+	// Override layers follow the anim of the attach bone
+	const int32 AttachColumn = Layer.AttachColumns_Generated[LayerColumn];
+	return (AttachColumn == INDEX_NONE) ? LayerTransform :
+		LayerTransform * SampleBoneTransform(Profile, BonePos, BoneRot, AnimIndex, Time, AttachColumn, bInterpolate);
+}
+
+FTransform FVertexAnimDecoder::SampleRefPoseBoneTransform(const UVertexAnimProfile* Profile, const FVATextureData& BonePos, const FVATextureData& BoneRot,
+	const int32 BoneIndex)
+{
+	// Row 0, the ref pose is baked without being part of any anim
+	return FTransform(
+		DecodeQuat(BoneRot.GetTexel(BoneIndex)),
+		DecodeVectorHDR(BonePos.GetTexel(BoneIndex), Profile->MaxValuePosition_Bone));
+}
+
+void FVertexAnimDecoder::DecodeVertexOffsets(const UVertexAnimProfile* Profile, const FVATextureData& Offsets,
+	TArrayView<const FVAVertexQuery> Queries, TArrayView<FVector> OutOffsets, const bool bInterpolate)
+{
+	check(Queries.Num() == OutOffsets.Num());
+	check(Offsets.IsValid());
+
+	const float HalfBound = Profile->MaxValueOffset_Vert * 0.5f;
+	const int32 NumBatches = FMath::DivideAndRoundUp(Queries.Num(), DecodeBatchSize);
+
+	ParallelFor(NumBatches, [&](int32 BatchIndex)
+	{
+		const VectorRegister HalfBoundReg = VectorSetFloat1(HalfBound);
+		const int32 Start = BatchIndex * DecodeBatchSize;
+		const int32 End = FMath::Min(Start + DecodeBatchSize, Queries.Num());
+
+		for (int32 i = Start; i < End; i++)
+		{
+			const FVAVertexQuery& Query = Queries[i];
+			const FVAFrameSample Sample = CalcFrameSample(Profile->Anims_Vert[Query.AnimIndex], Query.Time);
+
+			// DecodeVectorHDR, RGB * ((A + 1) * 0.5 * Bound)
+			const FLinearColor TexelA = Offsets.GetTexel((CalcRow_Vert(Profile, Query.AnimIndex, Sample.FrameA) * Offsets.Width) + Query.VertexIndex);
+			const VectorRegister RegA = VectorLoad(&TexelA.R);
+			VectorRegister Result = VectorMultiply(RegA,
+				VectorMultiply(VectorAdd(VectorReplicate(RegA, 3), GlobalVectorConstants::FloatOne), HalfBoundReg));
+
+			if (bInterpolate)
+			{
+				const FLinearColor TexelB = Offsets.GetTexel((CalcRow_Vert(Profile, Query.AnimIndex, Sample.FrameB) * Offsets.Width) + Query.VertexIndex);
+				const VectorRegister RegB = VectorLoad(&TexelB.R);
+				const VectorRegister ResultB = VectorMultiply(RegB,
+					VectorMultiply(VectorAdd(VectorReplicate(RegB, 3), GlobalVectorConstants::FloatOne), HalfBoundReg));
+
+				Result = VectorMultiplyAdd(VectorSubtract(ResultB, Result), VectorSetFloat1(Sample.Alpha), Result);
+			}
+
+			VectorStoreFloat3(Result, &OutOffsets[i]);
+		}
+	}, NumBatches < 2);
+}
+
+void FVertexAnimDecoder::DecodeBoneTransforms(const UVertexAnimProfile* Profile, const FVATextureData& BonePos, const FVATextureData& BoneRot,
+	TArrayView<const FVABoneQuery> Queries, TArrayView<FTransform> OutTransforms, const bool bInterpolate)
+{
+	check(Queries.Num() == OutTransforms.Num());
+	check(BonePos.IsValid() && BoneRot.IsValid());
+
+	const int32 NumBatches = FMath::DivideAndRoundUp(Queries.Num(), DecodeBatchSize);
+
+	ParallelFor(NumBatches, [&](int32 BatchIndex)
+	{
+		const int32 Start = BatchIndex * DecodeBatchSize;
+		const int32 End = FMath::Min(Start + DecodeBatchSize, Queries.Num());
+
+		for (int32 i = Start; i < End; i++)
+		{
+			const FVABoneQuery& Query = Queries[i];
+			OutTransforms[i] = Profile->Layers_Bone.IsValidIndex(Query.LayerIndex) ?
+				SampleLayeredBoneTransform(Profile, BonePos, BoneRot, Query.AnimIndex, Query.Time, Query.LayerIndex, Query.LayerTime, Query.BoneIndex, bInterpolate) :
+				SampleBoneTransform(Profile, BonePos, BoneRot, Query.AnimIndex, Query.Time, Query.BoneIndex, bInterpolate, Query.bMirror);
+		}
+	}, NumBatches < 2);
+}
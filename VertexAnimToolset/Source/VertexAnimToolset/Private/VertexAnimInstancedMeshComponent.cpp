@@ -0,0 +1,94 @@
+// Copyright 2019-2021 Rexocrates. All Rights Reserved.
+
+#include "VertexAnimInstancedMeshComponent.h"
+
+#include "VertexAnimProfile.h"
+
+
+void UVertexAnimInstancedMeshComponent::SetInstanceAnim(int32 InstanceIndex, bool bBoneAnim, int32 AnimIndex, bool bUpdateBounds)
+{
+	if (InstanceIndex < 0) return;
+
+	if (InstanceAnims.Num() <= InstanceIndex)
+	{
+		InstanceAnims.SetNum(InstanceIndex + 1);
+	}
+
+	InstanceAnims[InstanceIndex].BoneAnim = bBoneAnim;
+	InstanceAnims[InstanceIndex].AnimIndex = AnimIndex;
+
+	if (bUpdateBounds)
+	{
+		UpdateBounds();
+		MarkRenderTransformDirty();
+	}
+}
+
+FBoxSphereBounds UVertexAnimInstancedMeshComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+	if ((Profile == NULL) || (PerInstanceSMData.Num() == 0))
+	{
+		return Super::CalcBounds(LocalToWorld);
+	}
+
+	const FBox AllAnimsBounds = Profile->CalcAllAnimsBounds();
+	if (!AllAnimsBounds.IsValid)
+	{
+		return Super::CalcBounds(LocalToWorld);
+	}
+
+	const FMatrix LocalToWorldMatrix = LocalToWorld.ToMatrixWithScale();
+	FBox Out(ForceInit);
+
+	for (int32 i = 0; i < PerInstanceSMData.Num(); i++)
+	{
+		FBox InstanceBounds = AllAnimsBounds;
+
+		if (InstanceAnims.IsValidIndex(i) && (InstanceAnims[i].AnimIndex != INDEX_NONE))
+		{
+			const FBox AnimBounds = Profile->GetAnimBounds(InstanceAnims[i].BoneAnim, InstanceAnims[i].AnimIndex);
+			if (AnimBounds.IsValid) InstanceBounds = AnimBounds;
+		}
+
+		Out += InstanceBounds.TransformBy(PerInstanceSMData[i].Transform * LocalToWorldMatrix);
+	}
+
+	return FBoxSphereBounds(Out);
+}
+
+bool UVertexAnimInstancedMeshComponent::RemoveInstance(int32 InstanceIndex)
+{
+	// Keep the anims parallel to the instances, removal shifts the following instances down
+	if (InstanceAnims.IsValidIndex(InstanceIndex))
+	{
+		InstanceAnims.RemoveAt(InstanceIndex);
+	}
+
+	return Super::RemoveInstance(InstanceIndex);
+}
+
+bool UVertexAnimInstancedMeshComponent::RemoveInstances(const TArray<int32>& InstancesToRemove)
+{
+	// Highest index first, the same order the instances are removed in
+	TArray<int32> SortedInstances = InstancesToRemove;
+	SortedInstances.Sort(TGreater<int32>());
+
+	int32 Previous = INDEX_NONE;
+	for (const int32 InstanceIndex : SortedInstances)
+	{
+		if ((InstanceIndex != Previous) && InstanceAnims.IsValidIndex(InstanceIndex))
+		{
+			InstanceAnims.RemoveAt(InstanceIndex);
+		}
+		Previous = InstanceIndex;
+	}
+
+	return Super::RemoveInstances(InstancesToRemove);
+}
+
+void UVertexAnimInstancedMeshComponent::ClearInstances()
+{
+	InstanceAnims.Empty();
+
+	Super::ClearInstances();
+}
@@ -0,0 +1,203 @@
+// Copyright 2019-2021 Rexocrates. All Rights Reserved.
+
+#include "VertexAnimPlaybackComponent.h"
+
+#include "VertexAnimProfile.h"
+
+#include "Engine/Texture2D.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "Components/InstancedStaticMeshComponent.h"
+
+
+UVertexAnimPlaybackComponent::UVertexAnimPlaybackComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = true;
+}
+
+int32 UVertexAnimPlaybackComponent::AddSlot(bool bBoneAnim, int32 AnimIndex, float Phase, float PlayRate, bool bMirror)
+{
+	FVAPlaybackSlot Slot;
+	Slot.BoneAnim = bBoneAnim;
+	Slot.AnimIndex = AnimIndex;
+	Slot.Phase = FMath::Frac(Phase);
+	Slot.PlayRate = PlayRate;
+	Slot.Mirror = bBoneAnim && bMirror;
+
+	return Slots.Add(Slot);
+}
+
+int32 UVertexAnimPlaybackComponent::FindOrAddSlot(bool bBoneAnim, int32 AnimIndex, float Phase, bool bMirror)
+{
+	const int32 Buckets = FMath::Max(1, NumPhaseBuckets);
+	const float QuantizedPhase = (FMath::FloorToInt(FMath::Frac(Phase) * Buckets) % Buckets) / (float)Buckets;
+
+	for (int32 i = 0; i < Slots.Num(); i++)
+	{
+		if ((Slots[i].BoneAnim == bBoneAnim) && (Slots[i].AnimIndex == AnimIndex) && (Slots[i].Mirror == (bBoneAnim && bMirror)) &&
+			(Slots[i].LayerIndex == INDEX_NONE) &&
+			(Slots[i].PlayRate == 1.f) && FMath::IsNearlyEqual(Slots[i].Phase, QuantizedPhase))
+		{
+			return i;
+		}
+	}
+
+	return AddSlot(bBoneAnim, AnimIndex, QuantizedPhase, 1.f, bMirror);
+}
+
+void UVertexAnimPlaybackComponent::SetSlotLayer(int32 SlotIndex, int32 LayerIndex, float LayerPhase)
+{
+	if (!Slots.IsValidIndex(SlotIndex)) return;
+
+	FVAPlaybackSlot& Slot = Slots[SlotIndex];
+	Slot.LayerIndex = Slot.BoneAnim ? LayerIndex : INDEX_NONE;
+	Slot.LayerPhase = FMath::Frac(LayerPhase);
+	Slot.LayerTime_Generated = 0.f;
+}
+
+void UVertexAnimPlaybackComponent::AssignInstanceToSlot(UInstancedStaticMeshComponent* InstancedComponent, int32 InstanceIndex, int32 SlotIndex, int32 CustomDataIndex)
+{
+	if (InstancedComponent == NULL) return;
+
+	// Resizes the per instance custom data too, other custom data floats are kept
+	if (InstancedComponent->NumCustomDataFloats <= CustomDataIndex)
+	{
+		InstancedComponent->SetNumCustomDataFloats(CustomDataIndex + 1);
+	}
+
+	InstancedComponent->SetCustomDataValue(InstanceIndex, CustomDataIndex, (float)SlotIndex, true);
+}
+
+void UVertexAnimPlaybackComponent::BindMaterial(UMaterialInstanceDynamic* Material)
+{
+	if (Material == NULL) return;
+
+	BoundMaterials.AddUnique(Material);
+	Material->SetTextureParameterValue(SlotTableParameterName, SlotTableTexture);
+	Material->SetTextureParameterValue(SlotLayerTableParameterName, SlotLayerTableTexture);
+	Material->SetScalarParameterValue(SlotCountParameterName, (float)Slots.Num());
+}
+
+void UVertexAnimPlaybackComponent::AdvanceSlots(float DeltaTime)
+{
+	if (Profile == NULL) return;
+
+	for (FVAPlaybackSlot& Slot : Slots)
+	{
+		const TArray <FVASequenceData>& Anims = Slot.BoneAnim ? Profile->Anims_Bone : Profile->Anims_Vert;
+		if (!Anims.IsValidIndex(Slot.AnimIndex)) continue;
+
+		// Speed_Generated is 1 / Length, so the time stays normalized
+		Slot.Time_Generated = FMath::Frac(Slot.Time_Generated + (DeltaTime * Anims[Slot.AnimIndex].Speed_Generated * Slot.PlayRate));
+
+		if (Slot.BoneAnim && Profile->Layers_Bone.IsValidIndex(Slot.LayerIndex))
+		{
+			const FVASequenceData& Layer = Profile->Layers_Bone[Slot.LayerIndex].Anim;
+			Slot.LayerTime_Generated = FMath::Frac(Slot.LayerTime_Generated + (DeltaTime * Layer.Speed_Generated * Slot.PlayRate));
+		}
+	}
+}
+
+float UVertexAnimPlaybackComponent::GetSlotFrame(int32 SlotIndex) const
+{
+	if ((Profile == NULL) || !Slots.IsValidIndex(SlotIndex)) return 0.f;
+
+	const FVAPlaybackSlot& Slot = Slots[SlotIndex];
+	const TArray <FVASequenceData>& Anims = Slot.BoneAnim ? Profile->Anims_Bone : Profile->Anims_Vert;
+	if (!Anims.IsValidIndex(Slot.AnimIndex)) return 0.f;
+
+	return FMath::Frac(Slot.Time_Generated + Slot.Phase) * Anims[Slot.AnimIndex].NumFrames;
+}
+
+float UVertexAnimPlaybackComponent::GetSlotLayerFrame(int32 SlotIndex) const
+{
+	if ((Profile == NULL) || !Slots.IsValidIndex(SlotIndex)) return 0.f;
+
+	const FVAPlaybackSlot& Slot = Slots[SlotIndex];
+	if (!Slot.BoneAnim || !Profile->Layers_Bone.IsValidIndex(Slot.LayerIndex)) return 0.f;
+
+	return FMath::Frac(Slot.LayerTime_Generated + Slot.LayerPhase) * Profile->Layers_Bone[Slot.LayerIndex].Anim.NumFrames;
+}
+
+void UVertexAnimPlaybackComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	AdvanceSlots(DeltaTime);
+	UpdateSlotTable();
+}
+
+void UVertexAnimPlaybackComponent::UpdateSlotTable()
+{
+	if ((Profile == NULL) || (Slots.Num() == 0)) return;
+
+	const int32 Width = Slots.Num();
+	const bool bResized = (SlotTableTexture == NULL) || (SlotTableTexture->GetSizeX() != Width);
+
+	// Freed by the render thread once the upload is done
+	FLinearColor* Data = new FLinearColor[Width];
+	FLinearColor* LayerData = new FLinearColor[Width];
+	for (int32 i = 0; i < Width; i++)
+	{
+		const FVAPlaybackSlot& Slot = Slots[i];
+		const TArray <FVASequenceData>& Anims = Slot.BoneAnim ? Profile->Anims_Bone : Profile->Anims_Vert;
+
+		if (Anims.IsValidIndex(Slot.AnimIndex))
+		{
+			Data[i] = FLinearColor(
+				(float)Anims[Slot.AnimIndex].AnimStart_Generated,
+				GetSlotFrame(i),
+				(float)Anims[Slot.AnimIndex].NumFrames,
+				Slot.BoneAnim ? (Slot.Mirror ? 2.f : 1.f) : 0.f);
+		}
+		else
+		{
+			Data[i] = FLinearColor(0, 0, 0, 0);
+		}
+
+		if (Slot.BoneAnim && Profile->Layers_Bone.IsValidIndex(Slot.LayerIndex))
+		{
+			const FVASequenceData& Layer = Profile->Layers_Bone[Slot.LayerIndex].Anim;
+			LayerData[i] = FLinearColor((float)Layer.AnimStart_Generated, GetSlotLayerFrame(i), (float)Layer.NumFrames, (float)(Slot.LayerIndex + 1));
+		}
+		else
+		{
+			LayerData[i] = FLinearColor(0, 0, 0, 0);
+		}
+	}
+
+	UploadOneRowTexture(SlotTableTexture, Width, Data);
+	UploadOneRowTexture(SlotLayerTableTexture, Width, LayerData);
+
+	if (bResized)
+	{
+		for (UMaterialInstanceDynamic* Material : BoundMaterials)
+		{
+			if (Material)
+			{
+				Material->SetTextureParameterValue(SlotTableParameterName, SlotTableTexture);
+				Material->SetTextureParameterValue(SlotLayerTableParameterName, SlotLayerTableTexture);
+				Material->SetScalarParameterValue(SlotCountParameterName, (float)Width);
+			}
+		}
+	}
+}
+
+void UVertexAnimPlaybackComponent::UploadOneRowTexture(UTexture2D*& Texture, const int32 Width, FLinearColor* Data)
+{
+	if ((Texture == NULL) || (Texture->GetSizeX() != Width))
+	{
+		Texture = UTexture2D::CreateTransient(Width, 1, PF_A32B32G32R32F);
+		Texture->Filter = TextureFilter::TF_Nearest;
+		Texture->SRGB = false;
+		Texture->UpdateResource();
+	}
+
+	FUpdateTextureRegion2D* Region = new FUpdateTextureRegion2D(0, 0, 0, 0, Width, 1);
+	Texture->UpdateTextureRegions(0, 1, Region, Width * sizeof(FLinearColor), sizeof(FLinearColor), (uint8*)Data,
+		[](uint8* SrcData, const FUpdateTextureRegion2D* Regions)
+	{
+		delete[] (FLinearColor*)SrcData;
+		delete Regions;
+	});
+}
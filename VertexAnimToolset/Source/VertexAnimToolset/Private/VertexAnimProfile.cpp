@@ -8,6 +8,9 @@
 #include "Runtime/Engine/Classes/Kismet/KismetRenderingLibrary.h"
 
 #include "Rendering/SkeletalMeshModel.h"
+#include "Animation/AnimationAsset.h"
+#include "Animation/Skeleton.h"
+#include "AssetData.h"
 
 
 int32 UVertexAnimProfile::CalcTotalNumOfFrames_Vert() const
@@ -41,7 +44,44 @@ int32 UVertexAnimProfile::CalcTotalNumOfFrames_Bone() const
 
 int32 UVertexAnimProfile::CalcTotalRequiredHeight_Bone() const
 {
-	return CalcTotalNumOfFrames_Bone();
+	return CalcTotalNumOfFrames_Bone() + CalcTotalRows_BoneLayers();
+}
+
+int32 UVertexAnimProfile::CalcTotalNumOfFrames_BoneLayers() const
+{
+	int32 Out = 0;
+
+	for (int32 i = 0; i < Layers_Bone.Num(); i++)
+	{
+		Out += Layers_Bone[i].Anim.NumFrames;
+	}
+
+	return Out;
+}
+
+int32 UVertexAnimProfile::CalcTotalRows_BoneLayers() const
+{
+	int32 Out = 0;
+
+	for (int32 i = 0; i < Layers_Bone.Num(); i++)
+	{
+		Out += Layers_Bone[i].CalcNumRows();
+	}
+
+	return Out;
+}
+
+int32 UVertexAnimProfile::CalcStartHeightOfLayer_Bone(const int32 LayerIndex) const
+{
+	// After the ref pose row and the frames of the bone anims
+	int32 Out = CalcTotalNumOfFrames_Bone() + 1;
+
+	for (int32 i = 0; i < LayerIndex; i++)
+	{
+		Out += Layers_Bone[i].CalcNumRows();
+	}
+
+	return Out;
 }
 
 int32 UVertexAnimProfile::CalcStartHeightOfAnim_Vert(const int32 AnimIndex) const
@@ -67,3 +107,320 @@ int32 UVertexAnimProfile::CalcStartHeightOfAnim_Bone(const int32 AnimIndex) cons
 
 	return Out + 1;
 }
+
+// Distinct rows of the frame row tables, the frames of clips without one all have rows of their own
+static int32 CalcNumStoredFrames(const TArray <FVASequenceData>& Anims)
+{
+	TSet <int32> Rows;
+	int32 Out = 0;
+
+	for (const FVASequenceData& Anim : Anims)
+	{
+		if (Anim.FrameRows_Generated.Num() == 0)
+		{
+			Out += Anim.NumFrames;
+			continue;
+		}
+
+		Rows.Append(Anim.FrameRows_Generated);
+	}
+
+	return Out + Rows.Num();
+}
+
+int32 UVertexAnimProfile::CalcNumStoredFrames_Vert() const
+{
+	return CalcNumStoredFrames(Anims_Vert);
+}
+
+int32 UVertexAnimProfile::CalcNumStoredFrames_Bone() const
+{
+	return CalcNumStoredFrames(Anims_Bone);
+}
+
+void UVertexAnimProfile::CalcLayout_Vert(const int32 NumUniqueVerts, int32& OutRowsPerFrame, FIntPoint& OutSize) const
+{
+	if (AutoSize)
+	{
+		const int32 XSize = FMath::Min(MaxWidth, (int32)FMath::RoundUpToPowerOfTwo(NumUniqueVerts));
+		OutRowsPerFrame = FMath::CeilToInt((float)(NumUniqueVerts) / (float)(XSize));
+		OutSize = FIntPoint(
+			XSize,
+			FMath::RoundUpToPowerOfTwo(OutRowsPerFrame * CalcTotalNumOfFrames_Vert()));
+	}
+	else
+	{
+		OutRowsPerFrame = FMath::RoundUpToPowerOfTwo((float)(NumUniqueVerts) / (float)(OverrideSize_Vert.X));
+		OutSize = OverrideSize_Vert;
+	}
+}
+
+void UVertexAnimProfile::CalcLayout_Bone(const int32 NumBones, FIntPoint& OutSize) const
+{
+	if (AutoSize)
+	{
+		const int32 XSize = FMath::Clamp((int32)FMath::RoundUpToPowerOfTwo(NumBones), 8, MaxWidth);
+		OutSize = FIntPoint(
+			XSize,
+			FMath::RoundUpToPowerOfTwo(CalcTotalRequiredHeight_Bone() + 1));
+	}
+	else
+	{
+		OutSize = OverrideSize_Bone;
+	}
+}
+
+FVAProfileEstimate UVertexAnimProfile::CalcEstimate(const int32 NumUniqueVerts, const int32 NumBones) const
+{
+	// Baked textures are RGBA16F
+	const int64 BytesPerTexel = 8;
+
+	FVAProfileEstimate Out;
+	Out.NumUniqueVerts = NumUniqueVerts;
+	Out.NumBones = NumBones;
+
+	if (Anims_Vert.Num())
+	{
+		int32 RowsPerFrame = 0;
+		CalcLayout_Vert(NumUniqueVerts, RowsPerFrame, Out.TextureSize_Vert);
+		Out.RequiredHeight_Vert = RowsPerFrame * CalcTotalNumOfFrames_Vert();
+
+		const int64 Texels = (int64)Out.TextureSize_Vert.X * Out.TextureSize_Vert.Y;
+		Out.TextureBytes_Vert = Texels * BytesPerTexel;
+		Out.WastedTexels_Vert = Texels - ((int64)NumUniqueVerts * CalcTotalNumOfFrames_Vert());
+
+		switch (NormalEncoding)
+		{
+		case EVANormalEncoding::Delta:
+		case EVANormalEncoding::QTangent: Out.TextureBytes_Normals = Texels * BytesPerTexel; break;
+		case EVANormalEncoding::Octahedral: Out.TextureBytes_Normals = Texels * 2; break;
+		default: break;
+		}
+
+		// Offset and normal
+		Out.FetchesPerVertex_Vert = (NormalEncoding == EVANormalEncoding::OctahedralInOffsets) ? 1 : 2;
+		Out.NumUVChannels++;
+		Out.bFitsHeight &= Out.RequiredHeight_Vert <= Out.TextureSize_Vert.Y;
+	}
+
+	if (Anims_Bone.Num())
+	{
+		CalcLayout_Bone(NumBones, Out.TextureSize_Bone);
+		Out.RequiredHeight_Bone = CalcTotalRequiredHeight_Bone() + 1;
+
+		const int64 Texels = (int64)Out.TextureSize_Bone.X * Out.TextureSize_Bone.Y;
+		Out.TextureBytes_Bone = Texels * BytesPerTexel;
+		Out.WastedTexels_Bone = Texels - ((int64)NumBones * Out.RequiredHeight_Bone);
+
+		// Position and rotation of one bone, or of the 4 influences with full skinning
+		Out.FetchesPerVertex_Bone = FullBoneSkinning ? 8 : 2;
+		Out.NumUVChannels += FullBoneSkinning ? 2 : 1;
+		// Vertex ids share the bone anim channel
+		if (VertexIdAddressing && Anims_Vert.Num() && !FullBoneSkinning) Out.NumUVChannels--;
+		Out.bUsesVertexColors = FullBoneSkinning;
+		Out.bFitsHeight &= Out.RequiredHeight_Bone <= Out.TextureSize_Bone.Y;
+	}
+
+	// The compaction depends on the baked frames, it is not estimated
+	Out.bUpperBound = (FVertexAnimDecoder::bMaterialsReadFrameRows && DeduplicateFrames) || (SparseVertAnim && Anims_Vert.Num() && (NormalEncoding == EVANormalEncoding::Delta));
+
+	Out.TotalBytes = Out.TextureBytes_Vert + Out.TextureBytes_Normals + (2 * Out.TextureBytes_Bone);
+	Out.bWithinSizeLimit = (Out.TextureSize_Vert.GetMax() <= 4096) && (Out.TextureSize_Bone.GetMax() <= 4096);
+
+	return Out;
+}
+
+FBox UVertexAnimProfile::GetAnimBounds(const bool bBoneAnim, const int32 AnimIndex) const
+{
+	const TArray <FVASequenceData>& Anims = bBoneAnim ? Anims_Bone : Anims_Vert;
+	return Anims.IsValidIndex(AnimIndex) ? Anims[AnimIndex].Bounds_Generated : FBox(ForceInit);
+}
+
+FBox UVertexAnimProfile::GetFrameBounds(const bool bBoneAnim, const int32 AnimIndex, const int32 Frame) const
+{
+	const TArray <FVASequenceData>& Anims = bBoneAnim ? Anims_Bone : Anims_Vert;
+	if (!Anims.IsValidIndex(AnimIndex)) return FBox(ForceInit);
+
+	const FVASequenceData& Anim = Anims[AnimIndex];
+	return Anim.FrameBounds_Generated.IsValidIndex(Frame) ? Anim.FrameBounds_Generated[Frame] : Anim.Bounds_Generated;
+}
+
+FBox UVertexAnimProfile::CalcAllAnimsBounds() const
+{
+	FBox Out(ForceInit);
+
+	for (int32 i = 0; i < Anims_Vert.Num(); i++)
+	{
+		Out += Anims_Vert[i].Bounds_Generated;
+	}
+
+	for (int32 i = 0; i < Anims_Bone.Num(); i++)
+	{
+		Out += Anims_Bone[i].Bounds_Generated;
+	}
+
+	for (int32 i = 0; i < Layers_Bone.Num(); i++)
+	{
+		Out += Layers_Bone[i].Anim.Bounds_Generated;
+	}
+
+	return Out;
+}
+
+void UVertexAnimProfile::SyncHybridAnims()
+{
+	if (!HybridBake)
+	{
+		// A plain bake would bake the synced clips as vert anims
+		if (HybridAnimsSynced_Generated) Anims_Vert.Reset();
+		HybridAnimsSynced_Generated = false;
+		return;
+	}
+
+	HybridAnimsSynced_Generated = true;
+	Anims_Vert.SetNum(Anims_Bone.Num());
+
+	for (int32 i = 0; i < Anims_Bone.Num(); i++)
+	{
+		Anims_Vert[i].SequenceRef = Anims_Bone[i].SequenceRef;
+		Anims_Vert[i].NumFrames = Anims_Bone[i].NumFrames;
+	}
+}
+
+FVAProfileSummary UVertexAnimProfile::CalcSummary() const
+{
+	FVAProfileSummary Out;
+	Out.NumAnims_Vert = Anims_Vert.Num();
+	Out.NumAnims_Bone = Anims_Bone.Num();
+	Out.Frames_Vert = CalcTotalNumOfFrames_Vert();
+	Out.Frames_Bone = CalcTotalNumOfFrames_Bone();
+	Out.AutoSize = AutoSize;
+	Out.OverrideSizeMax_Vert = OverrideSize_Vert.GetMax();
+	Out.HybridBake = HybridBake;
+	Out.HybridSelection = (HybridMaterialSlots.Num() > 0) || (HybridBones.Num() > 0);
+
+	// The bone anims decide when there are both
+	USkeleton* Skeleton = NULL;
+	if (Anims_Vert.Num() && Anims_Vert[0].SequenceRef) Skeleton = Anims_Vert[0].SequenceRef->GetSkeleton();
+	if (Anims_Bone.Num() && Anims_Bone[0].SequenceRef) Skeleton = Anims_Bone[0].SequenceRef->GetSkeleton();
+	if (Skeleton) Out.Skeleton = Skeleton->GetPathName();
+
+	TArray <const FVASequenceData*> AllAnims;
+	for (const FVASequenceData& Anim : Anims_Vert) AllAnims.Add(&Anim);
+	for (const FVASequenceData& Anim : Anims_Bone) AllAnims.Add(&Anim);
+	for (const FVABoneLayerData& Layer : Layers_Bone) AllAnims.Add(&Layer.Anim);
+
+	for (const FVASequenceData* Anim : AllAnims)
+	{
+		if (Anim->SequenceRef == NULL) Out.AnimError = 6;
+		else if (Anim->SequenceRef->GetSkeleton() != Skeleton) Out.AnimError = 7;
+		else if (Anim->NumFrames < 1) Out.AnimError = 8;
+
+		if (Out.AnimError) return Out;
+	}
+
+	return Out;
+}
+
+void FVAProfileSummary::ToTags(TArray <UObject::FAssetRegistryTag>& OutTags) const
+{
+	typedef UObject::FAssetRegistryTag FTag;
+
+	OutTags.Add(FTag(TEXT("Skeleton"), Skeleton, FTag::TT_Alphabetical));
+	OutTags.Add(FTag(TEXT("NumAnims_Vert"), LexToString(NumAnims_Vert), FTag::TT_Numerical));
+	OutTags.Add(FTag(TEXT("NumAnims_Bone"), LexToString(NumAnims_Bone), FTag::TT_Numerical));
+	OutTags.Add(FTag(TEXT("Frames_Vert"), LexToString(Frames_Vert), FTag::TT_Numerical));
+	OutTags.Add(FTag(TEXT("Frames_Bone"), LexToString(Frames_Bone), FTag::TT_Numerical));
+	OutTags.Add(FTag(TEXT("HybridBake"), LexToString(HybridBake), FTag::TT_Alphabetical));
+	OutTags.Add(FTag(TEXT("AutoSize"), LexToString(AutoSize), FTag::TT_Hidden));
+	OutTags.Add(FTag(TEXT("OverrideSizeMax_Vert"), LexToString(OverrideSizeMax_Vert), FTag::TT_Hidden));
+	OutTags.Add(FTag(TEXT("HybridSelection"), LexToString(HybridSelection), FTag::TT_Hidden));
+	OutTags.Add(FTag(TEXT("AnimError"), LexToString(AnimError), FTag::TT_Hidden));
+}
+
+bool FVAProfileSummary::FromAssetData(const FAssetData& AssetData)
+{
+	if (!AssetData.GetTagValue(TEXT("AnimError"), AnimError)) return false;
+
+	AssetData.GetTagValue(TEXT("Skeleton"), Skeleton);
+	AssetData.GetTagValue(TEXT("NumAnims_Vert"), NumAnims_Vert);
+	AssetData.GetTagValue(TEXT("NumAnims_Bone"), NumAnims_Bone);
+	AssetData.GetTagValue(TEXT("Frames_Vert"), Frames_Vert);
+	AssetData.GetTagValue(TEXT("Frames_Bone"), Frames_Bone);
+	AssetData.GetTagValue(TEXT("HybridBake"), HybridBake);
+	AssetData.GetTagValue(TEXT("AutoSize"), AutoSize);
+	AssetData.GetTagValue(TEXT("OverrideSizeMax_Vert"), OverrideSizeMax_Vert);
+	AssetData.GetTagValue(TEXT("HybridSelection"), HybridSelection);
+	return true;
+}
+
+void UVertexAnimProfile::PostLoad()
+{
+	Super::PostLoad();
+
+	CacheBoneQueryData();
+}
+
+void UVertexAnimProfile::GetAssetRegistryTags(TArray<FAssetRegistryTag>& OutTags) const
+{
+	Super::GetAssetRegistryTags(OutTags);
+
+	CalcSummary().ToTags(OutTags);
+}
+
+#if WITH_EDITOR
+void UVertexAnimProfile::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	SyncHybridAnims();
+}
+#endif
+
+void UVertexAnimProfile::CacheBoneQueryData()
+{
+	BoneColumnMap.Empty(BoneNames_Generated.Num());
+	RefPoseBoneTransforms.Empty(BoneNames_Generated.Num());
+
+	for (int32 i = 0; i < BoneNames_Generated.Num(); i++)
+	{
+		BoneColumnMap.Add(BoneNames_Generated[i], i);
+	}
+
+	if (BonePosData_CPU.IsValid() && BoneRotData_CPU.IsValid())
+	{
+		for (int32 i = 0; i < BonePosData_CPU.Width; i++)
+		{
+			RefPoseBoneTransforms.Add(FVertexAnimDecoder::SampleRefPoseBoneTransform(this, BonePosData_CPU, BoneRotData_CPU, i));
+		}
+	}
+}
+
+int32 UVertexAnimProfile::FindBoneColumn(const FName BoneName) const
+{
+	const int32* Found = BoneColumnMap.Find(BoneName);
+	return Found ? *Found : INDEX_NONE;
+}
+
+void UVertexAnimProfile::BuildMirrorColumns()
+{
+	MirrorColumns_Generated.Reset();
+	if (MirrorBonePairs.Num() == 0) return;
+
+	MirrorColumns_Generated.SetNumUninitialized(BoneNames_Generated.Num());
+	for (int32 i = 0; i < MirrorColumns_Generated.Num(); i++)
+	{
+		MirrorColumns_Generated[i] = i;
+	}
+
+	for (const FVAMirrorBonePair& Pair : MirrorBonePairs)
+	{
+		// A pair with a bone that has no column is left out, its other bone mirrors onto itself
+		const int32 ColumnA = FindBoneColumn(Pair.BoneA);
+		const int32 ColumnB = FindBoneColumn(Pair.BoneB);
+		if ((ColumnA == INDEX_NONE) || (ColumnB == INDEX_NONE)) continue;
+
+		MirrorColumns_Generated[ColumnA] = ColumnB;
+		MirrorColumns_Generated[ColumnB] = ColumnA;
+	}
+}
@@ -0,0 +1,90 @@
+// Copyright 2019-2021 Rexocrates. All Rights Reserved.
+
+#include "VertexAnimSockets.h"
+
+#include "VertexAnimProfile.h"
+#include "VertexAnimDecoder.h"
+
+#include "Async/ParallelFor.h"
+
+
+// Queries handled per worker task in GetSocketTransforms
+static const int32 SocketBatchSize = 512;
+
+
+FTransform FVertexAnimSockets::CalcComponentSpaceTransform(const UVertexAnimProfile* Profile, const int32 AnimIndex, const float Time, const int32 BoneColumn,
+	const bool bInterpolate, const bool bMirror, const int32 LayerIndex, const float LayerTime)
+{
+	// The bone textures hold ref pose to animated pose transforms, apply them on top of the component space ref pose.
+	// Mirrored, the bone keeps its own ref pose and moves like the verts skinned to it do
+	const FTransform Skinning = Profile->Layers_Bone.IsValidIndex(LayerIndex) ?
+		FVertexAnimDecoder::SampleLayeredBoneTransform(
+			Profile, Profile->BonePosData_CPU, Profile->BoneRotData_CPU, AnimIndex, Time, LayerIndex, LayerTime, BoneColumn, bInterpolate) :
+		FVertexAnimDecoder::SampleBoneTransform(
+			Profile, Profile->BonePosData_CPU, Profile->BoneRotData_CPU, AnimIndex, Time, BoneColumn, bInterpolate, bMirror);
+
+	return Profile->GetRefPoseBoneTransform(BoneColumn) * Skinning;
+}
+
+bool FVertexAnimSockets::GetSocketTransform(const UVertexAnimProfile* Profile, const FVASocketQuery& Query, FTransform& OutTransform, const bool bInterpolate)
+{
+	const int32 BoneColumn = Profile->FindBoneColumn(Query.BoneName);
+
+	if ((BoneColumn == INDEX_NONE) || !Profile->Anims_Bone.IsValidIndex(Query.AnimIndex)) return false;
+
+	OutTransform = Query.RelativeTransform *
+		CalcComponentSpaceTransform(Profile, Query.AnimIndex, Query.Time, BoneColumn, bInterpolate, Query.Mirror, Query.LayerIndex, Query.LayerTime) *
+		Query.InstanceTransform;
+	return true;
+}
+
+void FVertexAnimSockets::GetSocketTransforms(const UVertexAnimProfile* Profile, TArrayView<const FVASocketQuery> Queries,
+	TArrayView<FTransform> OutTransforms, TArrayView<bool> OutValid, const bool bInterpolate)
+{
+	check(Queries.Num() == OutTransforms.Num());
+	check((OutValid.Num() == 0) || (OutValid.Num() == Queries.Num()));
+
+	if (!Profile->BonePosData_CPU.IsValid() || !Profile->BoneRotData_CPU.IsValid())
+	{
+		for (int32 i = 0; i < OutValid.Num(); i++) OutValid[i] = false;
+		return;
+	}
+
+	const int32 NumBatches = FMath::DivideAndRoundUp(Queries.Num(), SocketBatchSize);
+
+	ParallelFor(NumBatches, [&](int32 BatchIndex)
+	{
+		const int32 Start = BatchIndex * SocketBatchSize;
+		const int32 End = FMath::Min(Start + SocketBatchSize, Queries.Num());
+
+		// Queries are usually grouped by bone, only look up the column when the name changes
+		FName CachedName = NAME_None;
+		int32 CachedColumn = INDEX_NONE;
+
+		for (int32 i = Start; i < End; i++)
+		{
+			const FVASocketQuery& Query = Queries[i];
+
+			if ((i == Start) || (Query.BoneName != CachedName))
+			{
+				CachedName = Query.BoneName;
+				CachedColumn = Profile->FindBoneColumn(CachedName);
+			}
+
+			const bool bValid = (CachedColumn != INDEX_NONE) && Profile->Anims_Bone.IsValidIndex(Query.AnimIndex);
+
+			if (bValid)
+			{
+				OutTransforms[i] = Query.RelativeTransform *
+					CalcComponentSpaceTransform(Profile, Query.AnimIndex, Query.Time, CachedColumn, bInterpolate, Query.Mirror,
+						Query.LayerIndex, Query.LayerTime) * Query.InstanceTransform;
+			}
+			else
+			{
+				OutTransforms[i] = Query.InstanceTransform;
+			}
+
+			if (OutValid.Num()) OutValid[i] = bValid;
+		}
+	}, NumBatches < 2);
+}
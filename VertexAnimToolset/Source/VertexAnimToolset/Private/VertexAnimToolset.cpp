@@ -9,6 +9,8 @@
 
 #define LOCTEXT_NAMESPACE "FVertexAnimToolsetModule"
 
+DEFINE_LOG_CATEGORY(LogVertexAnimToolset);
+
 void FVertexAnimToolsetModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
@@ -0,0 +1,53 @@
+// Copyright 2019-2021 Rexocrates. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "VertexAnimProfile.h"
+#include "VertexAnimBoneAsset.generated.h"
+
+class UTexture2D;
+class USkeleton;
+
+// Bone anim textures of one skeleton, baked once and shared by the profiles of all meshes using the skeleton.
+// The texture columns are the bone indices of the skeleton reference skeleton, so they do not depend on the mesh
+UCLASS(BlueprintType)
+class VERTEXANIMTOOLSET_API UVertexAnimBoneAsset : public UDataAsset
+{
+	GENERATED_BODY()
+public:
+
+	UPROPERTY(VisibleAnywhere, Category = BoneAnim)
+		USkeleton* Skeleton = NULL;
+	// Clips as baked, with their generated start rows and speeds
+	UPROPERTY(VisibleAnywhere, Category = BoneAnim)
+		TArray <FVASequenceData> Anims_Bone;
+
+	UPROPERTY(VisibleAnywhere, Category = Generated_BoneAnim)
+		FIntPoint Size_Bone = FIntPoint(0, 0);
+	UPROPERTY(VisibleAnywhere, Category = Generated_BoneAnim)
+		float MaxValuePosition_Bone = 0;
+	UPROPERTY(VisibleAnywhere, Category = Generated_BoneAnim)
+		UTexture2D* BonePosTexture = NULL;
+	UPROPERTY(VisibleAnywhere, Category = Generated_BoneAnim)
+		UTexture2D* BoneRotTexture = NULL;
+	UPROPERTY(VisibleAnywhere, Category = Generated_BoneAnim)
+		UTexture2D* FrameRowTexture_Bone = NULL;
+
+	// Bone name of each bone texture column
+	UPROPERTY(VisibleAnywhere, Category = Generated_BoneAnim)
+		TArray <FName> BoneNames_Generated;
+	UPROPERTY()
+		FVATextureData BonePosData_CPU;
+	UPROPERTY()
+		FVATextureData BoneRotData_CPU;
+
+	// True when the textures hold these clips of the skeleton, with the same frame counts, in textures of this width and at most this height
+	bool HoldsClips(const USkeleton* InSkeleton, const TArray <FVASequenceData>& InAnims, const FIntPoint& InSize) const;
+
+	// The generated bone anim data of the profile points to the shared textures, the per mesh bounds are left alone
+	void CopyToProfile(UVertexAnimProfile* Profile) const;
+	// Takes over the bone anims just baked for the profile
+	void CopyFromProfile(const UVertexAnimProfile* Profile, USkeleton* InSkeleton);
+};
@@ -0,0 +1,179 @@
+// Copyright 2019-2021 Rexocrates. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VertexAnimDecoder.generated.h"
+
+class UTexture2D;
+class UVertexAnimProfile;
+struct FVASequenceData;
+
+// CPU copy of a baked RGBA16F VAT texture, 4 half floats per texel in the same layout as the texture source
+USTRUCT()
+struct VERTEXANIMTOOLSET_API FVATextureData
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY()
+		int32 Width = 0;
+	UPROPERTY()
+		int32 Height = 0;
+	UPROPERTY()
+		TArray <uint16> Texels;
+
+	// SrcWidth allows keeping only the first InWidth columns of wider data, 0 means same as InWidth
+	void Init(const int32 InWidth, const int32 InHeight, const TArray <FFloat16Color>& Data, const int32 SrcWidth = 0);
+
+#if WITH_EDITORONLY_DATA
+	// Reads the RGBA16F source data of a baked texture, G16 sources (octahedral normals) keep their raw value in R, see GetRawR
+	bool InitFromTexture(UTexture2D* Texture);
+#endif
+
+	bool IsValid() const
+	{
+		return (Width > 0) && (Height > 0) && (Texels.Num() == Width * Height * 4);
+	}
+
+	FORCEINLINE FLinearColor GetTexel(const int32 Index) const
+	{
+		const uint16* Src = &Texels[Index * 4];
+		FFloat16 R, G, B, A;
+		R.Encoded = Src[0];
+		G.Encoded = Src[1];
+		B.Encoded = Src[2];
+		A.Encoded = Src[3];
+		return FLinearColor(R.GetFloat(), G.GetFloat(), B.GetFloat(), A.GetFloat());
+	}
+
+	FORCEINLINE FLinearColor GetTexel(const int32 X, const int32 Y) const
+	{
+		return GetTexel((Y * Width) + X);
+	}
+
+	FORCEINLINE uint16 GetRawR(const int32 Index) const
+	{
+		return Texels[Index * 4];
+	}
+};
+
+// Frame pair and blend alpha sampled for a point in time
+struct FVAFrameSample
+{
+	int32 FrameA = 0;
+	int32 FrameB = 0;
+	float Alpha = 0.f;
+};
+
+// Vertex query, VertexIndex is the texel index inside a frame (the unique vertex index of the grid UVs)
+struct FVAVertexQuery
+{
+	int32 AnimIndex = 0;
+	float Time = 0.f;
+	int32 VertexIndex = 0;
+};
+
+// Bone query, BoneIndex is the texture column (UVertexAnimProfile::FindBoneColumn of the bone name)
+struct FVABoneQuery
+{
+	int32 AnimIndex = 0;
+	float Time = 0.f;
+	int32 BoneIndex = 0;
+	bool bMirror = false;
+	// Bone layer combined with the anim (UVertexAnimProfile::Layers_Bone), layered queries are not mirrored
+	int32 LayerIndex = INDEX_NONE;
+	float LayerTime = 0.f;
+};
+
+// CPU reference of the decode material functions (DecodeVector, DecodeVectorHDR, DecodeQuat, ExtractAnimData_*)
+class VERTEXANIMTOOLSET_API FVertexAnimDecoder
+{
+public:
+	static FVector DecodeVector(const FLinearColor& Texel, const float Bound);
+	static FVector DecodeVectorHDR(const FLinearColor& Texel, const float Bound);
+	static FQuat DecodeQuat(const FLinearColor& Texel);
+
+	// Octahedral mapping of a unit vector to -1 - 1 and back
+	static FVector2D EncodeOctahedral(const FVector& N);
+	static FVector DecodeOctahedral(const FVector2D& Oct);
+
+	// Octahedral normal quantized to BitsPerAxis per axis, X in the high bits
+	static uint32 QuantizeOctahedral(const FVector& N, const int32 BitsPerAxis);
+	static FVector DequantizeOctahedral(const uint32 Packed, const int32 BitsPerAxis);
+
+	// Tangent frame as a unit quaternion with W kept away from 0, negated for a negative bitangent sign
+	static FQuat EncodeQTangent(const FVector& TangentX, const FVector& TangentZ, const float BitangentSign);
+	static void DecodeQTangent(const FLinearColor& Texel, FVector& OutTangentX, FVector& OutTangentY, FVector& OutTangentZ);
+
+	// Bits per axis of EVANormalEncoding::Octahedral (the G16 texel) and EVANormalEncoding::OctahedralInOffsets (the packed index in A)
+	static constexpr int32 OctahedralBits_Texture = 8;
+	static constexpr int32 OctahedralBits_Offsets = 7;
+
+	// Looping frame sample for a time in seconds, the same way the _Interp material functions do it
+	static FVAFrameSample CalcFrameSample(const FVASequenceData& Anim, const float Time);
+
+	static int32 GridUVToVertexIndex(const FVector2D& UV, const FIntPoint& TextureSize);
+
+	// Largest index PackIndex can store, Index + 1024 has to stay below the half float infinity bits
+	static constexpr uint32 MaxPackedIndex = 0x7BFF - 1024;
+
+	// Index + 1024 as the bits of a normal half float, returned as the float of the same value so half precision UVs keep it exactly
+	static float PackIndex(const uint32 Index);
+	// Inverse of PackIndex, the same bit operations the material does on asuint of the UV
+	static int32 UnpackIndex(const float Packed);
+
+	// Vert anim UV X of the verts a hybrid bake leaves to the bone textures, the CPU decoder tests X < 0.
+	// The provided material functions do not test it yet, they sample texel (-1, Y) for these verts
+	static constexpr float BoneOnlyUV = -1.f;
+
+	// Vertex index of the vert anim UV of a vertex, for either grid or vertex id addressing, INDEX_NONE for bone only verts
+	static int32 UVToVertexIndex(const UVertexAnimProfile* Profile, const FVector2D& UV);
+	// Same, for the UV of UVChannel_VertAnim as stored in the mesh, UVComponent_VertAnim picks the component holding the vertex id
+	static int32 ChannelUVToVertexIndex(const UVertexAnimProfile* Profile, const FVector2D& ChannelUV);
+
+	// The provided material functions read row AnimStart_Generated + Frame and not the FrameRowTextures, DeduplicateFrames
+	// stays hidden and is not baked until they do, a deduplicated bake would play the wrong frames on the GPU
+	static constexpr bool bMaterialsReadFrameRows = false;
+
+	// First texture row of a baked frame
+	static int32 CalcRow_Vert(const UVertexAnimProfile* Profile, const int32 AnimIndex, const int32 Frame);
+	static int32 CalcRow_Bone(const UVertexAnimProfile* Profile, const int32 AnimIndex, const int32 Frame);
+
+	static FVector SampleVertexOffset(const UVertexAnimProfile* Profile, const FVATextureData& Offsets,
+		const int32 AnimIndex, const float Time, const int32 VertexIndex, const bool bInterpolate = true);
+	static FVector SampleVertexNormalDelta(const UVertexAnimProfile* Profile, const FVATextureData& Normals,
+		const int32 AnimIndex, const float Time, const int32 VertexIndex, const bool bInterpolate = true);
+	// Tangent frame of the QTangent encoding
+	static void SampleVertexTangentFrame(const UVertexAnimProfile* Profile, const FVATextureData& Normals,
+		const int32 AnimIndex, const float Time, const int32 VertexIndex,
+		FVector& OutTangentX, FVector& OutTangentY, FVector& OutTangentZ, const bool bInterpolate = true);
+	// Absolute normal of the octahedral encodings, Normals is the normals texture data or the offsets one for OctahedralInOffsets
+	static FVector SampleVertexNormal(const UVertexAnimProfile* Profile, const FVATextureData& Normals,
+		const int32 AnimIndex, const float Time, const int32 VertexIndex, const bool bInterpolate = true);
+
+	// Reflection of a component space transform across the plane with the Axis normal, S * Transform * S, still a rotation
+	static FTransform MirrorTransform(const FTransform& Transform, const EAxis::Type Axis);
+
+	// Returns the baked skinning (ref pose to animated pose) transform of the bone.
+	// Mirrored, the transform of the mirror column reflected across the mirror plane of the profile
+	static FTransform SampleBoneTransform(const UVertexAnimProfile* Profile, const FVATextureData& BonePos, const FVATextureData& BoneRot,
+		const int32 AnimIndex, const float Time, const int32 BoneIndex, const bool bInterpolate = true, const bool bMirror = false);
+	// Texel of a layer column in a frame of a bone layer
+	static int32 CalcTexel_BoneLayer(const UVertexAnimProfile* Profile, const int32 LayerIndex, const int32 Frame, const int32 LayerColumn, const int32 Width);
+	// Baked transform of a layer column, relative to its attach column for Override layers
+	static FTransform SampleBoneLayerTransform(const UVertexAnimProfile* Profile, const FVATextureData& BonePos, const FVATextureData& BoneRot,
+		const int32 LayerIndex, const float Time, const int32 LayerColumn, const bool bInterpolate = true);
+	// Skinning transform of the bone with the layer combined with the anim, the anim alone for bones outside the layer
+	static FTransform SampleLayeredBoneTransform(const UVertexAnimProfile* Profile, const FVATextureData& BonePos, const FVATextureData& BoneRot,
+		const int32 AnimIndex, const float Time, const int32 LayerIndex, const float LayerTime, const int32 BoneIndex, const bool bInterpolate = true);
+
+	// Returns the component space ref pose transform stored in row 0 of the bone textures
+	static FTransform SampleRefPoseBoneTransform(const UVertexAnimProfile* Profile, const FVATextureData& BonePos, const FVATextureData& BoneRot,
+		const int32 BoneIndex);
+
+	// Batch versions, large batches are split across worker threads
+	static void DecodeVertexOffsets(const UVertexAnimProfile* Profile, const FVATextureData& Offsets,
+		TArrayView<const FVAVertexQuery> Queries, TArrayView<FVector> OutOffsets, const bool bInterpolate = true);
+	static void DecodeBoneTransforms(const UVertexAnimProfile* Profile, const FVATextureData& BonePos, const FVATextureData& BoneRot,
+		TArrayView<const FVABoneQuery> Queries, TArrayView<FTransform> OutTransforms, const bool bInterpolate = true);
+};
@@ -0,0 +1,47 @@
+// Copyright 2019-2021 Rexocrates. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "VertexAnimInstancedMeshComponent.generated.h"
+
+class UVertexAnimProfile;
+
+// Anim currently played by an instance, used to size the bounds
+USTRUCT(BlueprintType)
+struct VERTEXANIMTOOLSET_API FVAInstanceAnim
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = InstanceAnim)
+		bool BoneAnim = false;
+
+	// INDEX_NONE uses the bounds of all the anims of the profile
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = InstanceAnim)
+		int32 AnimIndex = INDEX_NONE;
+};
+
+// Instanced static mesh whose bounds are the union of the baked animated bounds of the anim each instance plays,
+// instead of the ref pose bounds of the mesh inflated with a bounds scale
+UCLASS(ClassGroup = Rendering, meta = (BlueprintSpawnableComponent))
+class VERTEXANIMTOOLSET_API UVertexAnimInstancedMeshComponent : public UInstancedStaticMeshComponent
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = VertexAnim)
+		UVertexAnimProfile* Profile = NULL;
+
+	// Parallel to the instances, missing entries use the bounds of all the anims
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = VertexAnim)
+		TArray <FVAInstanceAnim> InstanceAnims;
+
+	UFUNCTION(BlueprintCallable, Category = "VertexAnim|Bounds")
+		void SetInstanceAnim(int32 InstanceIndex, bool bBoneAnim, int32 AnimIndex, bool bUpdateBounds = true);
+
+	virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+
+	virtual bool RemoveInstance(int32 InstanceIndex) override;
+	virtual bool RemoveInstances(const TArray<int32>& InstancesToRemove) override;
+	virtual void ClearInstances() override;
+};
@@ -0,0 +1,126 @@
+// Copyright 2019-2021 Rexocrates. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "VertexAnimPlaybackComponent.generated.h"
+
+class UTexture2D;
+class UMaterialInstanceDynamic;
+class UInstancedStaticMeshComponent;
+class UVertexAnimProfile;
+
+// Shared playback slot, a (clip, phase) pair advanced once for every instance referencing it
+USTRUCT(BlueprintType)
+struct VERTEXANIMTOOLSET_API FVAPlaybackSlot
+{
+	GENERATED_BODY()
+public:
+	// Use Anims_Bone of the profile instead of Anims_Vert
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = PlaybackSlot)
+		bool BoneAnim = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = PlaybackSlot)
+		int32 AnimIndex = 0;
+
+	// Normalized (0 - 1) offset into the anim
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = PlaybackSlot)
+		float Phase = 0.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = PlaybackSlot)
+		float PlayRate = 1.f;
+
+	// Plays a bone anim mirrored (UVertexAnimProfile::MirrorBonePairs), ignored for vert anims
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = PlaybackSlot)
+		bool Mirror = false;
+
+	// Bone layer (Layers_Bone of the profile) combined with the bone anim, -1 for none
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = PlaybackSlot)
+		int32 LayerIndex = INDEX_NONE;
+
+	// Normalized (0 - 1) offset into the layer
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = PlaybackSlot)
+		float LayerPhase = 0.f;
+
+	// Normalized (0 - 1) play position, advanced by the component
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = PlaybackSlotGenerated)
+		float Time_Generated = 0.f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = PlaybackSlotGenerated)
+		float LayerTime_Generated = 0.f;
+};
+
+// Advances a small table of shared playback slots and uploads it as a one row texture
+// (the bone layers of the slots go to a second one), instances then only need to store the index of the slot they play in their custom data
+UCLASS(ClassGroup = Rendering, meta = (BlueprintSpawnableComponent))
+class VERTEXANIMTOOLSET_API UVertexAnimPlaybackComponent : public UActorComponent
+{
+	GENERATED_BODY()
+public:
+	UVertexAnimPlaybackComponent();
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Playback)
+		UVertexAnimProfile* Profile = NULL;
+
+	// Number of phase buckets per anim used by FindOrAddSlot, higher values give more variation but more slots
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Playback, meta = (ClampMin = "1"))
+		int32 NumPhaseBuckets = 8;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Playback)
+		TArray <FVAPlaybackSlot> Slots;
+
+	UPROPERTY(EditAnywhere, Category = Material)
+		FName SlotTableParameterName = TEXT("VATSlotTable");
+	UPROPERTY(EditAnywhere, Category = Material)
+		FName SlotCountParameterName = TEXT("VATSlotCount");
+	UPROPERTY(EditAnywhere, Category = Material)
+		FName SlotLayerTableParameterName = TEXT("VATSlotLayerTable");
+
+	// Texel X = slot index, R: anim start row, G: current frame, B: num frames, A: 1 for bone anims, 2 for mirrored bone anims
+	UPROPERTY(Transient, VisibleInstanceOnly, BlueprintReadOnly, Category = Generated)
+		UTexture2D* SlotTableTexture = NULL;
+	// One row texture of the same width, texel X = slot index, R: layer start row, G: current layer frame, B: num layer frames,
+	// A: layer index + 1 (0 for none)
+	UPROPERTY(Transient, VisibleInstanceOnly, BlueprintReadOnly, Category = Generated)
+		UTexture2D* SlotLayerTableTexture = NULL;
+
+	UFUNCTION(BlueprintCallable, Category = "VertexAnim|Playback")
+		int32 AddSlot(bool bBoneAnim, int32 AnimIndex, float Phase, float PlayRate = 1.f, bool bMirror = false);
+
+	// Returns an existing slot playing the anim with the phase quantized to NumPhaseBuckets, or adds it
+	UFUNCTION(BlueprintCallable, Category = "VertexAnim|Playback")
+		int32 FindOrAddSlot(bool bBoneAnim, int32 AnimIndex, float Phase, bool bMirror = false);
+
+	// Combines a bone layer with the bone anim of the slot, -1 removes it
+	UFUNCTION(BlueprintCallable, Category = "VertexAnim|Playback")
+		void SetSlotLayer(int32 SlotIndex, int32 LayerIndex, float LayerPhase = 0.f);
+
+	// Writes the slot index into the per instance custom data of an instanced static mesh
+	UFUNCTION(BlueprintCallable, Category = "VertexAnim|Playback")
+		void AssignInstanceToSlot(UInstancedStaticMeshComponent* InstancedComponent, int32 InstanceIndex, int32 SlotIndex, int32 CustomDataIndex = 0);
+
+	UFUNCTION(BlueprintCallable, Category = "VertexAnim|Playback")
+		void BindMaterial(UMaterialInstanceDynamic* Material);
+
+	UFUNCTION(BlueprintCallable, Category = "VertexAnim|Playback")
+		void AdvanceSlots(float DeltaTime);
+
+	// Current frame of the slot relative to the start of its anim, fractional part is the interpolation alpha
+	UFUNCTION(BlueprintPure, Category = "VertexAnim|Playback")
+		float GetSlotFrame(int32 SlotIndex) const;
+
+	// Current frame of the layer of the slot, 0 without one
+	UFUNCTION(BlueprintPure, Category = "VertexAnim|Playback")
+		float GetSlotLayerFrame(int32 SlotIndex) const;
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+	void UpdateSlotTable();
+	// Creates a one row float texture when the width changed, queues the upload of Data, which is freed by the render thread
+	static void UploadOneRowTexture(UTexture2D*& Texture, const int32 Width, FLinearColor* Data);
+
+	UPROPERTY(Transient)
+		TArray <UMaterialInstanceDynamic*> BoundMaterials;
+};
@@ -4,10 +4,42 @@
 
 #include "CoreMinimal.h"
 #include "Engine/DataAsset.h"
+#include "VertexAnimDecoder.h"
 #include "VertexAnimProfile.generated.h"
 
 class UTexture2D;
 class UStaticMesh;
+class USkeletalMesh;
+class UVertexAnimBoneAsset;
+struct FAssetData;
+
+// Order unique verts are given vert anim texels in
+UENUM()
+enum class EVAVertOrder : uint8
+{
+	// Order the verts are first seen in the vertex buffer
+	FirstSeen,
+	// Order the index buffer first uses them in, close to the order the post transform cache shades them in
+	IndexBuffer,
+	// Along a Z curve through the bounds of the mesh
+	Morton
+};
+
+// How vert anims store the normal of a frame
+UENUM()
+enum class EVANormalEncoding : uint8
+{
+	// Delta to the ref pose normal in its own RGBA texture
+	Delta,
+	// Absolute normal, octahedral 8:8 in a 16 bit single channel texture, half the memory of the delta texture
+	Octahedral,
+	// Absolute normal, octahedral 7:7 packed into A of the offsets texel (PackIndex), no normals texture and one fetch per vertex.
+	// RGB then hold the offset relative to MaxValueOffset_Vert
+	OctahedralInOffsets,
+	// Absolute tangent frame as a quaternion (QTangent) in the RGBA16F normals texture, the sign of W is the bitangent sign.
+	// One fetch gives the normal, tangent and bitangent of normal mapped meshes
+	QTangent
+};
 
 // Struct Holding helper data specific to an Animation Sequence needed for the baking process
 USTRUCT(BlueprintType)
@@ -23,9 +55,133 @@ public:
 
 	UPROPERTY(EditAnywhere, Category = BakeSequenceGenerated)
 		int32 AnimStart_Generated = 0;
+	// Texture row of every frame when the bake deduplicated frames, empty for the contiguous AnimStart_Generated layout
+	UPROPERTY(VisibleAnywhere, Category = BakeSequenceGenerated)
+		TArray <int32> FrameRows_Generated;
 
 	UPROPERTY(EditAnywhere, Category = BakeSequenceGenerated)
 		float Speed_Generated = 1.f;
+
+	// Component space bounds of the skinned mesh over all baked frames
+	UPROPERTY(VisibleAnywhere, Category = BakeSequenceGenerated)
+		FBox Bounds_Generated = FBox(ForceInit);
+	UPROPERTY()
+		TArray <FBox> FrameBounds_Generated;
+};
+
+// How a bone layer combines with the base bone anim
+UENUM()
+enum class EVALayerBlend : uint8
+{
+	// The layer bones play the layer clip relative to the parent of their layer bone, which plays the base clip
+	Override,
+	// The layer clip, posed on top of the ref pose, is applied to the base clip
+	Additive
+};
+
+// Partial body bone clip combined per instance with any bone anim, its frames only hold the columns of the layer bones
+USTRUCT(BlueprintType)
+struct VERTEXANIMTOOLSET_API FVABoneLayerData
+{
+	GENERATED_BODY()
+public:
+	// AnimStart_Generated is the first row of the layer in the bone textures
+	UPROPERTY(EditAnywhere, Category = BoneLayer)
+		FVASequenceData Anim;
+	// Bones, with all their children, the layer drives
+	UPROPERTY(EditAnywhere, Category = BoneLayer)
+		TArray <FName> LayerBones;
+	UPROPERTY(EditAnywhere, Category = BoneLayer)
+		EVALayerBlend Blend = EVALayerBlend::Override;
+
+	// Frames side by side in a texture row, frame F is at row AnimStart_Generated + F / FramesPerRow,
+	// its layer columns start at column (F % FramesPerRow) * Columns_Generated.Num()
+	UPROPERTY(VisibleAnywhere, Category = BoneLayerGenerated)
+		int32 FramesPerRow_Generated = 0;
+	// Bone texture column of every layer column
+	UPROPERTY(VisibleAnywhere, Category = BoneLayerGenerated)
+		TArray <int32> Columns_Generated;
+	// Bone texture column of the parent of the layer bone of every layer column, INDEX_NONE at the skeleton root
+	UPROPERTY(VisibleAnywhere, Category = BoneLayerGenerated)
+		TArray <int32> AttachColumns_Generated;
+
+	int32 CalcNumRows() const
+	{
+		return (FramesPerRow_Generated > 0) ? FMath::DivideAndRoundUp(Anim.NumFrames, FramesPerRow_Generated) : 0;
+	}
+};
+
+// Pre-bake estimate of the textures and mesh data a profile produces, from the layout stages only
+struct VERTEXANIMTOOLSET_API FVAProfileEstimate
+{
+	int32 NumUniqueVerts = 0;
+	int32 NumBones = 0;
+
+	FIntPoint TextureSize_Vert = FIntPoint::ZeroValue;
+	FIntPoint TextureSize_Bone = FIntPoint::ZeroValue;
+	int32 RequiredHeight_Vert = 0;
+	int32 RequiredHeight_Bone = 0;
+
+	// Top mip size of one texture, each mode bakes two, vert anims one plus the normals texture
+	int64 TextureBytes_Vert = 0;
+	int64 TextureBytes_Normals = 0;
+	int64 TextureBytes_Bone = 0;
+	int64 TotalBytes = 0;
+
+	int64 WastedTexels_Vert = 0;
+	int64 WastedTexels_Bone = 0;
+
+	// Texture samples per vertex and frame, doubled by the _Interp material functions
+	int32 FetchesPerVertex_Vert = 0;
+	int32 FetchesPerVertex_Bone = 0;
+
+	// UV channels added by the bake on top of the ones of the mesh
+	int32 NumUVChannels = 0;
+	int32 NumMeshUVChannels = 0;
+	bool bUsesVertexColors = false;
+
+	bool bFitsHeight = true;
+	bool bWithinSizeLimit = true;
+	// SparseVertAnim or DeduplicateFrames compact the textures at bake time, the sizes are upper bounds
+	bool bUpperBound = false;
+};
+
+// Everything the bake dialog validates a profile on, also saved as asset registry tags so profiles can be filtered and validated without loading them
+struct VERTEXANIMTOOLSET_API FVAProfileSummary
+{
+	// Path name of the skeleton of the anims, empty without anims
+	FString Skeleton;
+
+	int32 NumAnims_Vert = 0;
+	int32 NumAnims_Bone = 0;
+	int32 Frames_Vert = 0;
+	int32 Frames_Bone = 0;
+
+	bool AutoSize = true;
+	int32 OverrideSizeMax_Vert = 0;
+
+	bool HybridBake = false;
+	// Hybrid material slots or bones are set
+	bool HybridSelection = false;
+
+	// First problem found walking the anims: 0 none, 6 invalid sequence ref, 7 different skeletons, 8 less than 1 frame
+	int32 AnimError = 0;
+
+	void ToTags(TArray <UObject::FAssetRegistryTag>& OutTags) const;
+	// False for profiles saved before the tags existed
+	bool FromAssetData(const FAssetData& AssetData);
+};
+
+// Left and right bones swapped when a bone anim plays mirrored
+USTRUCT(BlueprintType)
+struct VERTEXANIMTOOLSET_API FVAMirrorBonePair
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = MirrorBonePair)
+		FName BoneA;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = MirrorBonePair)
+		FName BoneB;
 };
 
 // Data asset holding all the helper data needed for the baking process
@@ -39,30 +195,135 @@ public:
 		bool AutoSize = true;
 	UPROPERTY(EditAnywhere, Category = AnimProfile)
 	int32 MaxWidth = 2048;
+	// Also bakes the visible meshes following the pose of the preview mesh (Persona additional meshes)
+	// into the same static mesh and textures so a crowd agent stays one instance and one draw
+	UPROPERTY(EditAnywhere, Category = AnimProfile)
+		bool MergeFollowerMeshes = true;
+	// Reorders the triangles of every section of the source models of the baked static mesh for the post transform vertex cache.
+	// The UE4 static mesh build cache optimizes the index buffers again and discards this order, so it has no effect on the
+	// rendered mesh, the BuiltACMR of the bake report shows the final order. Off by default
+	UPROPERTY(EditAnywhere, Category = AnimProfile)
+		bool OptimizeVertexCache = false;
+	// Then draws the triangle clusters facing outwards first to cut overdraw.
+	// Discarded by the static mesh build the same way, no effect on the rendered mesh
+	UPROPERTY(EditAnywhere, Category = AnimProfile)
+		bool OptimizeOverdraw = false;
+	// Frames matching an earlier frame, holds and loop ends within or across clips, share its texture rows.
+	// The row of AnimStart_Generated + Frame is then looked up in the FrameRowTexture of the textures. Only the CPU decoder
+	// does this lookup, so the option is hidden and ignored by the bake while FVertexAnimDecoder::bMaterialsReadFrameRows is false
+	UPROPERTY()
+		bool DeduplicateFrames = false;
+	// Max offset / bone position difference of matching frames, normals and rotations match within 1/255
+	UPROPERTY()
+		float DeduplicateTolerance = 0.01f;
 	
 	UPROPERTY(EditAnywhere, Category = VertAnim)
 		bool UVMergeDuplicateVerts = true;
+	// Verts of the same triangles in neighbouring texels share texture cache lines when a vertex wave fetches its frame,
+	// the bake report gives the simulated miss rate of the result (VertFetchMissRate)
+	UPROPERTY(EditAnywhere, Category = VertAnim)
+		EVAVertOrder VertOrder = EVAVertOrder::FirstSeen;
+	// Stores the unique vert index bit packed in one UV component instead of a grid UV, exact at any texture size.
+	// The material unpacks it (asuint) and derives Column = Index % Width and Row = Index / Width.
+	// With bone anims and without FullBoneSkinning the index goes into the free Y of the bone anim channel, saving a UV channel
+	UPROPERTY(EditAnywhere, Category = VertAnim)
+		bool VertexIdAddressing = false;
+	// Unique verts whose offset stays within SparseThreshold in every baked frame all read one shared zero texel,
+	// only the moving verts get texels of their own
+	// Needs Delta normals, static verts could not share a texel with absolute ones, the bake stops with other encodings
+	UPROPERTY(EditAnywhere, Category = VertAnim)
+		bool SparseVertAnim = false;
+	UPROPERTY(EditAnywhere, Category = VertAnim, meta = (ClampMin = "0"))
+		float SparseThreshold = 0.01f;
+	UPROPERTY(EditAnywhere, Category = VertAnim)
+		EVANormalEncoding NormalEncoding = EVANormalEncoding::Delta;
 	UPROPERTY(EditAnywhere, Category = VertAnim)
 	FIntPoint OverrideSize_Vert = FIntPoint(0, 0);
 	UPROPERTY(EditAnywhere, Category = VertAnim)
 	TArray <FVASequenceData> Anims_Vert;
 
+	// Simulates cloth continuously through every vert anim clip instead of restarting it for each frame,
+	// the frames are temporally coherent and the simulation cost grows with the clip length instead of the frame count
+	UPROPERTY(EditAnywhere, Category = ClothBake)
+		bool ContinuousCloth = false;
+	// Cloth simulation steps per second
+	UPROPERTY(EditAnywhere, Category = ClothBake, meta = (ClampMin = "1"))
+		float ClothSubstepRate = 60.f;
+	// Seconds simulated before the first frame, playing the end of the clip so the cloth settles into the loop
+	UPROPERTY(EditAnywhere, Category = ClothBake, meta = (ClampMin = "0"))
+		float ClothPreRoll = 1.f;
+	// Last frames of a clip blended towards its first frame to close the loop
+	UPROPERTY(EditAnywhere, Category = ClothBake, meta = (ClampMin = "0"))
+		int32 ClothLoopBlendFrames = 2;
+
 	UPROPERTY(EditAnywhere, Category = BoneAnim)
 		bool FullBoneSkinning = false;
+	// Bone anims are baked into this skeleton level asset, or taken from it without baking when it already holds the same clips,
+	// so the profiles of all meshes of a skeleton share one set of bone textures
+	UPROPERTY(EditAnywhere, Category = BoneAnim)
+		UVertexAnimBoneAsset* SharedBoneAnim = NULL;
+	// Only the bones the verts of the baked meshes are skinned to (the active bones of their LODs) and BoneMask get a bone texture column,
+	// instead of every bone of the skeleton
+	UPROPERTY(EditAnywhere, Category = BoneAnim)
+		bool ActiveBonesOnly = false;
+	// Bones kept in the bone textures without verts skinned to them, for sockets and attachments
+	UPROPERTY(EditAnywhere, Category = BoneAnim, meta = (EditCondition = "ActiveBonesOnly"))
+		TArray <FName> BoneMask;
+	// Bone anims play mirrored by reading the column of the other bone of a pair and reflecting its transform across the mirror plane,
+	// bones not listed mirror onto themselves. Both bones of a pair get columns with ActiveBonesOnly
+	UPROPERTY(EditAnywhere, Category = BoneAnim)
+		TArray <FVAMirrorBonePair> MirrorBonePairs;
+	// Normal of the mirror plane of the mesh, the plane goes through the component origin
+	UPROPERTY(EditAnywhere, Category = BoneAnim)
+		TEnumAsByte <EAxis::Type> MirrorAxis = EAxis::X;
 	UPROPERTY(EditAnywhere, Category = BoneAnim)
 	FIntPoint OverrideSize_Bone = FIntPoint(0, 0);
 	UPROPERTY(EditAnywhere, Category = BoneAnim)
 	TArray <FVASequenceData> Anims_Bone;
+	// Partial body clips baked after Anims_Bone and combined with them per instance, instead of baking every combination as a clip.
+	// Not used with SharedBoneAnim
+	UPROPERTY(EditAnywhere, Category = BoneAnim)
+		TArray <FVABoneLayerData> Layers_Bone;
+
+	// Bone anims drive the whole mesh and the verts selected below are vertex animated on top, with the same clips,
+	// in a vertex texture holding only them. Anims_Vert is kept in sync with Anims_Bone.
+	// Bone only verts get a vert anim UV X of -1, the material has to skip the offsets for them, the provided material functions do not yet
+	UPROPERTY(EditAnywhere, Category = HybridAnim)
+		bool HybridBake = false;
+	// Material slots whose verts are vertex animated
+	UPROPERTY(EditAnywhere, Category = HybridAnim)
+		TArray <FName> HybridMaterialSlots;
+	// Bones, with all their children, whose skinned verts are vertex animated
+	UPROPERTY(EditAnywhere, Category = HybridAnim)
+		TArray <FName> HybridBones;
+	// Min skin weight on one of the hybrid bones for a vert to be vertex animated
+	UPROPERTY(EditAnywhere, Category = HybridAnim, meta = (ClampMin = "0", ClampMax = "1"))
+		float HybridBoneWeightThreshold = 0.1f;
+	// Anims_Vert holds the clips synced from Anims_Bone, they are removed once HybridBake is turned off
+	UPROPERTY(VisibleAnywhere, Category = HybridAnim)
+		bool HybridAnimsSynced_Generated = false;
 
 	UPROPERTY(EditAnywhere, Category = AnimProfileGenerated)
 		UStaticMesh* StaticMesh = NULL;
 
+#if WITH_EDITORONLY_DATA
+	// Mesh the details panel estimate is made for, not used by the bake
+	UPROPERTY(EditAnywhere, Category = Estimate)
+		USkeletalMesh* EstimateMesh = NULL;
+#endif
+
 	UPROPERTY(EditAnywhere, Category = Generated_VertAnim)
 	int32 UVChannel_VertAnim = -1;
+	// Component of UVChannel_VertAnim holding the vert anim UV, 0 for a channel of its own, 1 for Y of the bone anim channel
+	UPROPERTY(EditAnywhere, Category = Generated_VertAnim)
+	int32 UVComponent_VertAnim = 0;
 	UPROPERTY(EditAnywhere, Category = Generated_VertAnim)
 	UTexture2D* OffsetsTexture = NULL;
 	UPROPERTY(EditAnywhere, Category = Generated_VertAnim)
 	UTexture2D* NormalsTexture = NULL;
+	// G16 texture row of every row of the contiguous layout, Index % Width and Index / Width, NULL without DeduplicateFrames
+	UPROPERTY(EditAnywhere, Category = Generated_VertAnim)
+	UTexture2D* FrameRowTexture_Vert = NULL;
 
 
 	UPROPERTY(EditAnywhere, Category = Generated_VertAnim)
@@ -78,17 +339,95 @@ public:
 		UTexture2D* BonePosTexture = NULL;
 	UPROPERTY(EditAnywhere, Category = Generated_BoneAnim)
 		UTexture2D* BoneRotTexture = NULL;
+	UPROPERTY(EditAnywhere, Category = Generated_BoneAnim)
+		UTexture2D* FrameRowTexture_Bone = NULL;
+	// G16, X = bone texture column, row 2 * Layer: layer column + 1 (0 outside the layer), row 2 * Layer + 1: attach column + 1
+	UPROPERTY(EditAnywhere, Category = Generated_BoneAnim)
+		UTexture2D* LayerTableTexture_Bone = NULL;
 
 	UPROPERTY(EditAnywhere, Category = Generated_BoneAnim)
 		float MaxValuePosition_Bone = 0;
 
+	// Bone name of each bone texture column
+	UPROPERTY(VisibleAnywhere, Category = Generated_BoneAnim)
+		TArray <FName> BoneNames_Generated;
+	// Column each bone texture column reads when mirrored, empty without MirrorBonePairs
+	UPROPERTY(VisibleAnywhere, Category = Generated_BoneAnim)
+		TArray <int32> MirrorColumns_Generated;
+	// G16 MirrorColumns_Generated for the materials, X = column, NULL without MirrorBonePairs
+	UPROPERTY(EditAnywhere, Category = Generated_BoneAnim)
+		UTexture2D* MirrorColumnTexture = NULL;
+	// CPU copies of the used columns and rows of the bone textures, for gameplay queries
+	UPROPERTY()
+		FVATextureData BonePosData_CPU;
+	UPROPERTY()
+		FVATextureData BoneRotData_CPU;
+
 	int32 CalcTotalNumOfFrames_Vert() const;
 	int32 CalcTotalRequiredHeight_Vert() const;
 
 	int32 CalcTotalNumOfFrames_Bone() const;
+	// Bone anim frames and bone layer rows
 	int32 CalcTotalRequiredHeight_Bone() const;
 
+	int32 CalcTotalNumOfFrames_BoneLayers() const;
+	int32 CalcTotalRows_BoneLayers() const;
+	int32 CalcStartHeightOfLayer_Bone(const int32 LayerIndex) const;
+
 	int32 CalcStartHeightOfAnim_Vert(const int32 AnimIndex) const;
 	int32 CalcStartHeightOfAnim_Bone(const int32 AnimIndex) const;
 
+	// Frames with rows of their own, fewer than the baked frames when frames were deduplicated
+	int32 CalcNumStoredFrames_Vert() const;
+	int32 CalcNumStoredFrames_Bone() const;
+
+	// Texture layout the bake uses for a number of unique verts / skeleton bones, honors AutoSize
+	void CalcLayout_Vert(const int32 NumUniqueVerts, int32& OutRowsPerFrame, FIntPoint& OutSize) const;
+	void CalcLayout_Bone(const int32 NumBones, FIntPoint& OutSize) const;
+
+	FVAProfileEstimate CalcEstimate(const int32 NumUniqueVerts, const int32 NumBones) const;
+
+	// Returns the animated bounds of the anim, invalid if not baked
+	FBox GetAnimBounds(const bool bBoneAnim, const int32 AnimIndex) const;
+	// Returns the animated bounds of a single baked frame, falls back to the bounds of the anim
+	FBox GetFrameBounds(const bool bBoneAnim, const int32 AnimIndex, const int32 Frame) const;
+	// Union of the bounds of all baked anims
+	FBox CalcAllAnimsBounds() const;
+
+	// Copies the clips of Anims_Bone into Anims_Vert for hybrid bakes, and removes them again once HybridBake is off
+	void SyncHybridAnims();
+
+	FVAProfileSummary CalcSummary() const;
+
+	virtual void PostLoad() override;
+	virtual void GetAssetRegistryTags(TArray<FAssetRegistryTag>& OutTags) const override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	// Rebuilds the bone name lookup and ref pose cache used by the socket queries
+	void CacheBoneQueryData();
+
+	// Returns the bone texture column of the bone or INDEX_NONE
+	int32 FindBoneColumn(const FName BoneName) const;
+
+	// Fills MirrorColumns_Generated from MirrorBonePairs and the current columns, needs CacheBoneQueryData
+	void BuildMirrorColumns();
+
+	// Column read in place of the column when mirrored
+	int32 FindMirrorColumn(const int32 BoneColumn) const
+	{
+		return MirrorColumns_Generated.IsValidIndex(BoneColumn) ? MirrorColumns_Generated[BoneColumn] : BoneColumn;
+	}
+
+	// Component space ref pose of the bone texture column, decoded from row 0
+	// Identity for columns outside the bone textures, the columns of socket queries come from user data
+	const FTransform& GetRefPoseBoneTransform(const int32 BoneColumn) const
+	{
+		return RefPoseBoneTransforms.IsValidIndex(BoneColumn) ? RefPoseBoneTransforms[BoneColumn] : FTransform::Identity;
+	}
+
+private:
+	TMap <FName, int32> BoneColumnMap;
+	TArray <FTransform> RefPoseBoneTransforms;
 };
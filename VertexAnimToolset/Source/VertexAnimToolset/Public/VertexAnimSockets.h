@@ -0,0 +1,61 @@
+// Copyright 2019-2021 Rexocrates. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VertexAnimSockets.generated.h"
+
+class UVertexAnimProfile;
+
+// Socket query for one instance playing a bone anim of the profile
+USTRUCT(BlueprintType)
+struct VERTEXANIMTOOLSET_API FVASocketQuery
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SocketQuery)
+		FTransform InstanceTransform;
+
+	// Index into Anims_Bone
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SocketQuery)
+		int32 AnimIndex = 0;
+
+	// Play time in seconds
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SocketQuery)
+		float Time = 0.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SocketQuery)
+		FName BoneName;
+
+	// Socket offset relative to the bone
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SocketQuery)
+		FTransform RelativeTransform;
+
+	// The instance plays the anim mirrored (UVertexAnimProfile::MirrorBonePairs)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SocketQuery)
+		bool Mirror = false;
+
+	// Index into Layers_Bone combined with the anim, -1 for none. Layered queries are not mirrored
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SocketQuery)
+		int32 LayerIndex = INDEX_NONE;
+	// Play time of the layer in seconds
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SocketQuery)
+		float LayerTime = 0.f;
+};
+
+// World space bone socket queries answered from the CPU copy of the bone textures kept by the profile,
+// so crowd members do not need a skeletal mesh to attach props or read hand / head positions
+class VERTEXANIMTOOLSET_API FVertexAnimSockets
+{
+public:
+	// Returns false if the bone is not baked in the profile
+	static bool GetSocketTransform(const UVertexAnimProfile* Profile, const FVASocketQuery& Query, FTransform& OutTransform, const bool bInterpolate = true);
+
+	// Bone names are resolved to texture columns once per run of equal names, OutValid can be empty if not needed
+	static void GetSocketTransforms(const UVertexAnimProfile* Profile, TArrayView<const FVASocketQuery> Queries,
+		TArrayView<FTransform> OutTransforms, TArrayView<bool> OutValid, const bool bInterpolate = true);
+
+	// Component space transform of a bone texture column, ref pose combined with the baked skinning transform
+	static FTransform CalcComponentSpaceTransform(const UVertexAnimProfile* Profile, const int32 AnimIndex, const float Time, const int32 BoneColumn,
+		const bool bInterpolate = true, const bool bMirror = false, const int32 LayerIndex = INDEX_NONE, const float LayerTime = 0.f);
+};
@@ -7,6 +7,8 @@
 #include "Modules/ModuleInterface.h"
 #include "Modules/ModuleManager.h"
 
+VERTEXANIMTOOLSET_API DECLARE_LOG_CATEGORY_EXTERN(LogVertexAnimToolset, Log, All);
+
 class FVertexAnimToolsetModule : public IModuleInterface
 {
 public:
@@ -41,7 +41,10 @@
 #include "Dialogs/DlgPickAssetPath.h"
 #include "AssetRegistryModule.h"
 
+#include "VertexAnimToolset.h"
 #include "VertexAnimProfile.h"
+#include "VertexAnimDecoder.h"
+#include "VertexAnimBoneAsset.h"
 
 
 #include "Framework/Notifications/NotificationManager.h"
@@ -103,78 +106,334 @@
 
 #include "MeshDescription.h"
 
+#include "ReferenceSkeleton.h"
+#include "Misc/ScopedSlowTask.h"
+#include "Misc/FileHelper.h"
+#include "Misc/EngineVersion.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "Stats/Stats.h"
+#include "Async/ParallelFor.h"
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+#include "UObject/GCObject.h"
+#include "Serialization/ObjectWriter.h"
+#include "Serialization/ObjectReader.h"
+
 #define LOCTEXT_NAMESPACE "VATEditorUtils"
 
+DECLARE_STATS_GROUP(TEXT("VertexAnimToolset"), STATGROUP_VertexAnimToolset, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Bake"), STAT_VAT_Bake, STATGROUP_VertexAnimToolset);
+DECLARE_CYCLE_STAT(TEXT("Bake Layout"), STAT_VATBake_Layout, STATGROUP_VertexAnimToolset);
+DECLARE_CYCLE_STAT(TEXT("Bake StaticMesh"), STAT_VATBake_StaticMesh, STATGROUP_VertexAnimToolset);
+DECLARE_CYCLE_STAT(TEXT("Bake Gather"), STAT_VATBake_Gather, STATGROUP_VertexAnimToolset);
+DECLARE_CYCLE_STAT(TEXT("Bake Encode"), STAT_VATBake_Encode, STATGROUP_VertexAnimToolset);
+DECLARE_CYCLE_STAT(TEXT("Bake Textures_Vert"), STAT_VATBake_Textures_Vert, STATGROUP_VertexAnimToolset);
+DECLARE_CYCLE_STAT(TEXT("Bake Textures_Bone"), STAT_VATBake_Textures_Bone, STATGROUP_VertexAnimToolset);
+DECLARE_CYCLE_STAT(TEXT("MapSkinVerts"), STAT_VAT_MapSkinVerts, STATGROUP_VertexAnimToolset);
+DECLARE_CYCLE_STAT(TEXT("MapActiveBones"), STAT_VAT_MapActiveBones, STATGROUP_VertexAnimToolset);
+DECLARE_CYCLE_STAT(TEXT("MapLODVertsToGrid"), STAT_VAT_MapLODVertsToGrid, STATGROUP_VertexAnimToolset);
+DECLARE_CYCLE_STAT(TEXT("CompactStaticVerts"), STAT_VAT_CompactStaticVerts, STATGROUP_VertexAnimToolset);
+DECLARE_CYCLE_STAT(TEXT("DeduplicateFrames"), STAT_VAT_DeduplicateFrames, STATGROUP_VertexAnimToolset);
+DECLARE_CYCLE_STAT(TEXT("EvaluatePose"), STAT_VAT_EvaluatePose, STATGROUP_VertexAnimToolset);
+DECLARE_CYCLE_STAT(TEXT("StoreFrameVertDeltas"), STAT_VAT_StoreFrameVertDeltas, STATGROUP_VertexAnimToolset);
+DECLARE_CYCLE_STAT(TEXT("StoreFrameBoneTransforms"), STAT_VAT_StoreFrameBoneTransforms, STATGROUP_VertexAnimToolset);
+DECLARE_CYCLE_STAT(TEXT("EncodeData_Vec"), STAT_VAT_EncodeData_Vec, STATGROUP_VertexAnimToolset);
+DECLARE_CYCLE_STAT(TEXT("EncodeData_Quat"), STAT_VAT_EncodeData_Quat, STATGROUP_VertexAnimToolset);
+DECLARE_CYCLE_STAT(TEXT("EncodeData_Octahedral"), STAT_VAT_EncodeData_Octahedral, STATGROUP_VertexAnimToolset);
+DECLARE_CYCLE_STAT(TEXT("SetTexture2"), STAT_VAT_SetTexture2, STATGROUP_VertexAnimToolset);
+
+// Insights event and stat of a bake helper
+#define VAT_SCOPE(Name) \
+	TRACE_CPUPROFILER_EVENT_SCOPE(VAT_##Name); \
+	SCOPE_CYCLE_COUNTER(STAT_VAT_##Name)
+
+// Per bake report, written as JSON to Saved/VertexAnimToolset/BakeReports
+struct FVATBakeReport
+{
+	TArray <TPair<FString, double>> StageSeconds;
+	double StartTime = FPlatformTime::Seconds();
+	uint64 StartUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+	uint64 PeakUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
 
-static void MapSkinVerts(
-	UVertexAnimProfile* InProfile, const TArray <FFinalSkinVertex>& SkinVerts,
-	TArray <int32>& UniqueVertsSourceID, TArray <FVector2D>& OutUVSet_Vert)
+	// A stage timed over several editor ticks adds up
+	void EndStage(const TCHAR* Name, const double Seconds)
+	{
+		TPair<FString, double>* Stage = StageSeconds.FindByPredicate([Name](const TPair<FString, double>& Other) { return Other.Key == Name; });
+		if (Stage) Stage->Value += Seconds;
+		else StageSeconds.Add(TPair<FString, double>(Name, Seconds));
+		PeakUsedPhysical = FMath::Max(PeakUsedPhysical, (uint64)FPlatformMemory::GetStats().UsedPhysical);
+	}
+
+	// Simulated vert anim texture cache miss rate of LOD 0, negative when there is no vert anim
+	float VertFetchMissRate = -1.f;
+	// Triangle order of the static mesh, empty when it was not built
+	FVATMeshOrderSettings MeshOrder;
+
+	void Write(const UVertexAnimProfile* Profile, const int32 NumVerts, const int32 NumUniqueVerts, const int32 NumBones, const int32 NumLODs) const;
+};
+
+// Wall time of a bake stage, recorded into the report when the scope ends
+struct FVATBakeStageScope
 {
-	TArray <FVector> UniqueVerts;
-	TArray <int32> UniqueID;
-	UniqueID.SetNumZeroed(SkinVerts.Num());
+	FVATBakeReport& Report;
+	const TCHAR* Name;
+	const double StartTime;
 
-	for (int32 i = 0; i < SkinVerts.Num(); i++)
+	FVATBakeStageScope(FVATBakeReport& InReport, const TCHAR* InName)
+		: Report(InReport), Name(InName), StartTime(FPlatformTime::Seconds()) {}
+
+	~FVATBakeStageScope()
+	{
+		Report.EndStage(Name, FPlatformTime::Seconds() - StartTime);
+	}
+};
+
+// Insights event, stat, LLM tag and report timing of a DoBakeProcess stage
+#define VAT_BAKE_STAGE_SCOPE(Report, Stage, Tag) \
+	TRACE_CPUPROFILER_EVENT_SCOPE(VATBake_##Stage); \
+	SCOPE_CYCLE_COUNTER(STAT_VATBake_##Stage); \
+	LLM_SCOPE(ELLMTag::Tag); \
+	FVATBakeStageScope VATBakeStageScope_##Stage(Report, TEXT(#Stage))
+
+
+// Unique vert index of every vert in first seen order, verts sharing an exact position are merged when bMerge
+static int32 FindUniqueVerts(
+	const bool bMerge, const int32 NumVerts, TFunctionRef<FVector(int32)> GetPosition,
+	TArray <int32>& OutUniqueID, TArray <int32>& OutUniqueSourceID)
+{
+	TMap <FVector, int32> UniqueMap;
+	OutUniqueID.SetNumUninitialized(NumVerts);
+	OutUniqueSourceID.Reserve(NumVerts);
+
+	for (int32 i = 0; i < NumVerts; i++)
 	{
-		int32 ID = INDEX_NONE;
+		const int32 NewID = OutUniqueSourceID.Num();
 
-		if (InProfile->UVMergeDuplicateVerts)
+		if (bMerge)
 		{
-			if (UniqueVerts.Find(SkinVerts[i].Position, ID))
-			{
-				UniqueID[i] = ID;
-			}
-			else
+			// Adding zero turns -0 into +0 so the hashed key compares like FVector::operator==
+			const FVector Key = GetPosition(i) + FVector::ZeroVector;
+			if (const int32* ID = UniqueMap.Find(Key))
 			{
-				UniqueID[i] = UniqueVerts.Num();
-				UniqueVerts.Add(SkinVerts[i].Position);
-				UniqueVertsSourceID.Add(i);
+				OutUniqueID[i] = *ID;
+				continue;
 			}
+
+			UniqueMap.Add(Key, NewID);
 		}
-		else
+
+		OutUniqueID[i] = NewID;
+		OutUniqueSourceID.Add(i);
+	}
+
+	return OutUniqueSourceID.Num();
+}
+
+// Verts of one mesh LOD a hybrid bake vertex animates, by material slot or by skin weight on the hybrid bones and their children
+static void CalcHybridVertMask(const UVertexAnimProfile* Profile, const USkeletalMesh* Mesh, const int32 LODIndex, TArray <bool>& OutMask)
+{
+	const FSkeletalMeshLODRenderData& LODData = Mesh->GetResourceForRendering()->LODRenderData[LODIndex];
+	const FSkeletalMeshLODModel& LODModel = Mesh->GetImportedModel()->LODModels[LODIndex];
+	const FSkeletalMeshLODInfo* LODInfo = Mesh->GetLODInfo(LODIndex);
+	const FReferenceSkeleton& RefSkeleton = Mesh->RefSkeleton;
+
+	// Parents always come before their children
+	TArray <bool> HybridBone;
+	HybridBone.SetNumZeroed(RefSkeleton.GetNum());
+	for (int32 B = 0; B < RefSkeleton.GetNum(); B++)
+	{
+		const int32 Parent = RefSkeleton.GetParentIndex(B);
+		HybridBone[B] = Profile->HybridBones.Contains(RefSkeleton.GetBoneName(B)) || ((Parent != INDEX_NONE) && HybridBone[Parent]);
+	}
+
+	const uint8 MinWeight = (uint8)FMath::Clamp(FMath::CeilToInt(Profile->HybridBoneWeightThreshold * 255.f), 1, 255);
+
+	OutMask.SetNumZeroed(LODData.GetNumVertices());
+
+	for (int32 s = 0; s < OutMask.Num(); s++)
+	{
+		int32 SectionIndex;
+		int32 VertIndex;
+		LODData.GetSectionFromVertexIndex(s, SectionIndex, VertIndex);
+		const FSkelMeshRenderSection& Section = LODData.RenderSections[SectionIndex];
+		const FSoftSkinVertex& SoftVert = LODModel.Sections[SectionIndex].SoftVertices[VertIndex];
+
+		int32 MaterialIndex = Section.MaterialIndex;
+		if (LODInfo && LODInfo->LODMaterialMap.IsValidIndex(SectionIndex) && (LODInfo->LODMaterialMap[SectionIndex] != INDEX_NONE))
+		{
+			MaterialIndex = LODInfo->LODMaterialMap[SectionIndex];
+		}
+
+		bool bHybrid = Mesh->Materials.IsValidIndex(MaterialIndex) && Profile->HybridMaterialSlots.Contains(Mesh->Materials[MaterialIndex].MaterialSlotName);
+
+		for (int32 Influence = 0; (Influence < MAX_TOTAL_INFLUENCES) && !bHybrid; Influence++)
 		{
-			UniqueID[i] = UniqueVerts.Num();
-			UniqueVerts.Add(SkinVerts[i].Position);
-			UniqueVertsSourceID.Add(i);
+			if ((SoftVert.InfluenceWeights[Influence] < MinWeight) || !Section.BoneMap.IsValidIndex(SoftVert.InfluenceBones[Influence])) continue;
+
+			bHybrid = HybridBone[Section.BoneMap[SoftVert.InfluenceBones[Influence]]];
 		}
+
+		OutMask[s] = bHybrid;
 	}
+}
+
+// Interleaves the low 10 bits of X, Y and Z
+static uint32 MortonCode3(const uint32 X, const uint32 Y, const uint32 Z)
+{
+	auto Spread = [](uint32 V)
+	{
+		V &= 0x3FF;
+		V = (V | (V << 16)) & 0x030000FF;
+		V = (V | (V << 8)) & 0x0300F00F;
+		V = (V | (V << 4)) & 0x030C30C3;
+		V = (V | (V << 2)) & 0x09249249;
+		return V;
+	};
+
+	return Spread(X) | (Spread(Y) << 1) | (Spread(Z) << 2);
+}
+
+// Texel order of unique verts as indices into UniqueSourceID, Verts gives the vert of every UniqueID entry.
+// Indices is the index buffer of all SkinVerts, only needed for EVAVertOrder::IndexBuffer
+static void OrderUniqueVerts(
+	const EVAVertOrder Order, const TArray <FFinalSkinVertex>& SkinVerts, const TArray <int32>& Verts,
+	const TArray <int32>& UniqueID, const TArray <int32>& UniqueSourceID, const TArray <uint32>& Indices, TArray <int32>& OutOrder)
+{
+	OutOrder.Reset(UniqueSourceID.Num());
+
+	if ((Order == EVAVertOrder::IndexBuffer) && Indices.Num())
+	{
+		TArray <int32> VertUnique;
+		VertUnique.Init(INDEX_NONE, SkinVerts.Num());
+		for (int32 i = 0; i < Verts.Num(); i++) VertUnique[Verts[i]] = UniqueID[i];
 
+		TArray <bool> Placed;
+		Placed.SetNumZeroed(UniqueSourceID.Num());
+		for (const uint32 Index : Indices)
+		{
+			const int32 u = VertUnique.IsValidIndex(Index) ? VertUnique[Index] : INDEX_NONE;
+			if ((u == INDEX_NONE) || Placed[u]) continue;
 
+			Placed[u] = true;
+			OutOrder.Add(u);
+		}
 
-	if (InProfile->AutoSize)
+		// Verts no triangle uses go last
+		for (int32 u = 0; u < UniqueSourceID.Num(); u++)
+		{
+			if (!Placed[u]) OutOrder.Add(u);
+		}
+	}
+	else if ((Order == EVAVertOrder::Morton) && UniqueSourceID.Num())
 	{
-		int32 XSize = FMath::Min(InProfile->MaxWidth, (int32)FMath::RoundUpToPowerOfTwo(UniqueVerts.Num()));
-		InProfile->RowsPerFrame_Vert = FMath::CeilToInt((float)(UniqueVerts.Num()) / (float)(XSize));
-		InProfile->OverrideSize_Vert = FIntPoint(
-			XSize,
-			FMath::RoundUpToPowerOfTwo(InProfile->CalcTotalRequiredHeight_Vert()));
+		FBox Bounds(ForceInit);
+		for (const int32 Source : UniqueSourceID) Bounds += SkinVerts[Verts[Source]].Position;
+		const FVector Scale = FVector(1023.f) / Bounds.GetSize().ComponentMax(FVector(KINDA_SMALL_NUMBER));
+
+		TArray <uint32> Codes;
+		Codes.SetNumUninitialized(UniqueSourceID.Num());
+		for (int32 u = 0; u < UniqueSourceID.Num(); u++)
+		{
+			const FVector Cell = (SkinVerts[Verts[UniqueSourceID[u]]].Position - Bounds.Min) * Scale;
+			Codes[u] = MortonCode3(FMath::Clamp((int32)Cell.X, 0, 1023), FMath::Clamp((int32)Cell.Y, 0, 1023), FMath::Clamp((int32)Cell.Z, 0, 1023));
+			OutOrder.Add(u);
+		}
+
+		OutOrder.StableSort([&Codes](const int32 A, const int32 B) { return Codes[A] < Codes[B]; });
 	}
 	else
 	{
-		InProfile->RowsPerFrame_Vert = //FMath::CeilToInt((float)(UniqueVerts.Num()) / (float)(InProfile->OverrideSize.X));
-			FMath::RoundUpToPowerOfTwo((float)(UniqueVerts.Num()) / (float)(InProfile->OverrideSize_Vert.X));
+		for (int32 u = 0; u < UniqueSourceID.Num(); u++) OutOrder.Add(u);
+	}
+}
+
+// Vert anim UV of a texel index under the current vert layout of the profile
+static FVector2D VertexIndexToUV(const UVertexAnimProfile* Profile, const int32 Index)
+{
+	if (Profile->VertexIdAddressing)
+	{
+		// Row and column are derived in the material
+		return FVector2D(FVATEditorUtils::PackBits(Index), 0.f);
+	}
+
+	const float XStep = 1.f / Profile->OverrideSize_Vert.X;
+	const float YStep = 1.f / Profile->OverrideSize_Vert.Y;
+
+	// I SWITCHED THESE to have the UVs lined horizontally.
+	const int32 GridX = Index % Profile->OverrideSize_Vert.X;
+	const int32 GridY = Index / Profile->OverrideSize_Vert.X;
+	return FVector2D(GridX * XStep, GridY * YStep);
+}
+
+// PartFirstVerts splits merged verts by part (first vert of every part followed by the total), verts of different parts are never merged.
+// With a VertMask only the masked verts get texels, the rest get BoneOnlyUV. Indices is the index buffer of SkinVerts for VertOrder
+static void MapSkinVerts(
+	UVertexAnimProfile* InProfile, const TArray <FFinalSkinVertex>& SkinVerts,
+	TArray <int32>& UniqueVertsSourceID, TArray <FVector2D>& OutUVSet_Vert,
+	const TArray <int32>& PartFirstVerts = TArray <int32>(), const TArray <bool>& VertMask = TArray <bool>(),
+	const TArray <uint32>& Indices = TArray <uint32>())
+{
+	VAT_SCOPE(MapSkinVerts);
+
+	TArray <int32> UniqueID;
+	UniqueID.Reserve(SkinVerts.Num());
+	UniqueVertsSourceID.Reset(SkinVerts.Num());
+
+	const bool bSplit = PartFirstVerts.Num() > 1;
+	const int32 NumParts = bSplit ? PartFirstVerts.Num() - 1 : 1;
+	for (int32 Part = 0; Part < NumParts; Part++)
+	{
+		const int32 FirstVert = bSplit ? PartFirstVerts[Part] : 0;
+		const int32 NumPartVerts = (bSplit ? PartFirstVerts[Part + 1] : SkinVerts.Num()) - FirstVert;
+
+		// Merged vert index of every vert taking part
+		TArray <int32> PartVerts;
+		PartVerts.Reserve(NumPartVerts);
+		for (int32 i = FirstVert; i < FirstVert + NumPartVerts; i++)
+		{
+			if ((VertMask.Num() == 0) || VertMask[i]) PartVerts.Add(i);
+		}
+
+		TArray <int32> PartUniqueID, PartUniqueSourceID;
+		FindUniqueVerts(InProfile->UVMergeDuplicateVerts, PartVerts.Num(),
+			[&SkinVerts, &PartVerts](int32 i) { return SkinVerts[PartVerts[i]].Position; }, PartUniqueID, PartUniqueSourceID);
+
+		TArray <int32> Order, Rank;
+		OrderUniqueVerts(InProfile->VertOrder, SkinVerts, PartVerts, PartUniqueID, PartUniqueSourceID, Indices, Order);
+		Rank.SetNumUninitialized(Order.Num());
+		for (int32 r = 0; r < Order.Num(); r++) Rank[Order[r]] = r;
+
+		const int32 FirstUnique = UniqueVertsSourceID.Num();
+		UniqueID.SetNum(FirstVert + NumPartVerts);
+		for (int32 i = FirstVert; i < FirstVert + NumPartVerts; i++) UniqueID[i] = INDEX_NONE;
+		for (int32 i = 0; i < PartVerts.Num(); i++) UniqueID[PartVerts[i]] = FirstUnique + Rank[PartUniqueID[i]];
+		for (const int32 u : Order) UniqueVertsSourceID.Add(PartVerts[PartUniqueSourceID[u]]);
 	}
+	const int32 NumUniqueVerts = UniqueVertsSourceID.Num();
+
+	FIntPoint TextureSize;
+	InProfile->CalcLayout_Vert(NumUniqueVerts, InProfile->RowsPerFrame_Vert, TextureSize);
+	InProfile->OverrideSize_Vert = TextureSize;
 
-	const float XStep = 1.f / InProfile->OverrideSize_Vert.X;
-	const float YStep = 1.f / InProfile->OverrideSize_Vert.Y;
-	const FVector2D HalfStep = FVector2D(XStep, YStep) / 2;
 	TArray <FVector2D> UniqueMappedUVs;
-	UniqueMappedUVs.SetNum(UniqueVerts.Num());
+	UniqueMappedUVs.SetNum(NumUniqueVerts);
 
-	for (int32 i = 0; i < UniqueVerts.Num(); i++)
+	for (int32 i = 0; i < NumUniqueVerts; i++)
 	{
-		// I SWITCHED THESE to have the UVs lined horizontally.
-		const int32 GridX = i % InProfile->OverrideSize_Vert.X;
-		const int32 GridY = i / InProfile->OverrideSize_Vert.X;
-		const FVector2D GridUV = FVector2D(GridX * XStep, GridY * YStep);
-		UniqueMappedUVs[i] = GridUV;
+		UniqueMappedUVs[i] = VertexIndexToUV(InProfile, i);
 	}
 
 	TArray <FVector2D> NewUVSet_Vert;
 	NewUVSet_Vert.SetNum(SkinVerts.Num());
 	for (int32 i = 0; i < SkinVerts.Num(); i++)
 	{
-		NewUVSet_Vert[i] = UniqueMappedUVs[UniqueID[i]];
+		NewUVSet_Vert[i] = (UniqueID[i] != INDEX_NONE) ? UniqueMappedUVs[UniqueID[i]] : FVector2D(FVertexAnimDecoder::BoneOnlyUV, FVertexAnimDecoder::BoneOnlyUV);
 	}
 	OutUVSet_Vert = NewUVSet_Vert;
 };
@@ -182,14 +441,11 @@ static void MapSkinVerts(
 static void MapActiveBones(
 	UVertexAnimProfile* InProfile, const int32 NumBones, TArray <FVector2D>& OutUVSet_Bone)
 {
-	if (InProfile->AutoSize)
-	{
-		int32 XSize = FMath::Clamp((int32)FMath::RoundUpToPowerOfTwo(NumBones), 8, InProfile->MaxWidth);
-		
-		InProfile->OverrideSize_Bone = FIntPoint(
-			XSize,
-			FMath::RoundUpToPowerOfTwo(InProfile->CalcTotalRequiredHeight_Bone() + 1));
-	}
+	VAT_SCOPE(MapActiveBones);
+
+	FIntPoint TextureSize;
+	InProfile->CalcLayout_Bone(NumBones, TextureSize);
+	InProfile->OverrideSize_Bone = TextureSize;
 
 	const float XStep = 1.f / InProfile->OverrideSize_Bone.X;
 	const float YStep = 1.f / InProfile->OverrideSize_Bone.Y;
@@ -217,653 +473,2892 @@ static void MapActiveBones(
 
 
 
-static void SkinnedMeshVATData(
-	USkinnedMeshComponent* InSkinnedMeshComponent,
-	UVertexAnimProfile* InProfile,
-	TArray <int32>& UniqueSourceID,
-	TArray <TArray <FVector2D>>& UVs_VertAnim,
-	TArray <TArray <FVector2D>>& UVs_BoneAnim1, 
-	TArray <TArray <FVector2D>>& UVs_BoneAnim2,
-	TArray <TArray <FColor>>& Colors_BoneAnim)
+// Gives each vert of a lower LOD the grid UV of the closest unique vert of the anim mesh LOD, appended to OutUVs.
+// Verts left out by the LOD mask get BoneOnlyUV
+static void MapLODVertsToGrid(
+	TArrayView <const FFinalSkinVertex> LODVerts, const TArray <FFinalSkinVertex>& AnimMeshVerts,
+	TArrayView <const int32> UniqueSourceID, const TArray <FVector2D>& GridUVs_Vert, TArray <FVector2D>& OutUVs,
+	TArrayView <const bool> LODMask = TArrayView <const bool>())
 {
-	UniqueSourceID.Empty();
-	UVs_VertAnim.Empty();
-	UVs_BoneAnim1.Empty();
-	UVs_BoneAnim2.Empty();
-	Colors_BoneAnim.Empty();
+	VAT_SCOPE(MapLODVertsToGrid);
 
-	const int32 NumLODs = InSkinnedMeshComponent->GetNumLODs();
-
-	const auto& RefSkeleton = InSkinnedMeshComponent->SkeletalMesh->RefSkeleton;
-	const auto& GlobalRefSkeleton = InSkinnedMeshComponent->SkeletalMesh->Skeleton->GetReferenceSkeleton();
+	OutUVs.Reserve(OutUVs.Num() + LODVerts.Num());
 
-	TArray <FVector2D> GridUVs_Vert;
-	TArray <FVector2D> GridUVs_Bone;
+	for (int32 o = 0; o < LODVerts.Num(); o++)
+	{
+		if ((LODMask.Num() && !LODMask[o]) || (UniqueSourceID.Num() == 0))
+		{
+			OutUVs.Add(FVector2D(FVertexAnimDecoder::BoneOnlyUV, FVertexAnimDecoder::BoneOnlyUV));
+			continue;
+		}
 
-	TArray<FFinalSkinVertex> AnimMeshFinalVertices;
-	int32 AnimMeshLOD = 0;
+		const FVector Pos = LODVerts[o].Position;
+		float Lowest = MAX_FLT;
+		int32 WinnerID = INDEX_NONE;
 
+		for (int32 u = 0; u < UniqueSourceID.Num(); u++)
+		{
+			const FVector TargetPos = AnimMeshVerts[UniqueSourceID[u]].Position;
 
-	int32 UVVertStart = -1;
-	int32 UVBoneStart = -2;
-	
-	FSkeletalMeshRenderData& SkeletalMeshRenderData = InSkinnedMeshComponent->MeshObject->GetSkeletalMeshRenderData();
-	
-	{
-		FSkeletalMeshLODRenderData& LODData = SkeletalMeshRenderData.LODRenderData[0];
-		MapActiveBones(InProfile, GlobalRefSkeleton.GetNum(), GridUVs_Bone);
+			const float Dist = FVector::Dist(Pos, TargetPos);
+			if (Dist < Lowest)
+			{
+				Lowest = Dist;
+				WinnerID = UniqueSourceID[u];
+			}
+		}
 
-		InSkinnedMeshComponent->GetCPUSkinnedVertices(AnimMeshFinalVertices, AnimMeshLOD);
-		MapSkinVerts(InProfile, AnimMeshFinalVertices, UniqueSourceID, GridUVs_Vert);
+		check(WinnerID != INDEX_NONE);
 
-		int32 UVChannelStart = LODData.StaticVertexBuffers.StaticMeshVertexBuffer.GetNumTexCoords();
-		UVVertStart = InProfile->Anims_Vert.Num() ? UVChannelStart : -1;
-		InProfile->UVChannel_VertAnim = UVVertStart;
-		UVBoneStart =
-			InProfile->Anims_Bone.Num() ? (InProfile->Anims_Vert.Num() ? UVChannelStart + 1 : UVChannelStart) : -2;
-		InProfile->UVChannel_BoneAnim = UVBoneStart;
-		InProfile->UVChannel_BoneAnim_Full = ((UVBoneStart >= 0) && InProfile->FullBoneSkinning) ? UVBoneStart + 1 : -1;
+		OutUVs.Add(GridUVs_Vert[WinnerID]);
 	}
+}
 
+// Non blocking warning of a bake that succeeds, also logged
+static void NotifyBakeWarning(const FText& Message)
+{
+	UE_LOG(LogVertexAnimToolset, Warning, TEXT("%s"), *Message.ToString());
 
-	for (int32 OverallLODIndex = 0; OverallLODIndex < NumLODs; OverallLODIndex++)
+	FNotificationInfo Info(Message);
+	Info.ExpireDuration = 10.0f;
+	Info.bUseLargeFont = false;
+	TSharedPtr<SNotificationItem> Notification = FSlateNotificationManager::Get().AddNotification(Info);
+	if (Notification.IsValid())
 	{
-		int32 LODIndexRead = FMath::Min(OverallLODIndex, NumLODs - 1);
+		Notification->SetCompletionState(SNotificationItem::CS_Fail);
+	}
+}
 
-		FSkeletalMeshLODInfo& SrcLODInfo = *(InSkinnedMeshComponent->SkeletalMesh->GetLODInfo(LODIndexRead));
+// Component space ref pose of every bone of the mesh, by bone name
+static void AddRefPoseBones(const FReferenceSkeleton& RefSkeleton, TMap <FName, FTransform>& InOutRefPose)
+{
+	for (int32 B = 0; B < RefSkeleton.GetNum(); B++)
+	{
+		InOutRefPose.Add(RefSkeleton.GetBoneName(B), FAnimationRuntime::GetComponentSpaceTransformRefPose(RefSkeleton, B));
+	}
+}
 
-		// Get the CPU skinned verts for this LOD, WAIT, if it changes LOD on each loop, does that not mean it changes??
-		TArray<FFinalSkinVertex> FinalVertices;
-		InSkinnedMeshComponent->GetCPUSkinnedVertices(FinalVertices, LODIndexRead);
+// Skinned mesh components baked into one mesh, the preview component first and then the visible meshes following its pose,
+// the order matches the one ConvertMeshesToStaticMesh appends their verts in.
+// Followers are skipped, with a dialog listing them, when they use another skeleton, when their bones shared with the parts
+// before them have another ref pose (row 0 holds one ref pose per bone) or when they are moved relative to the preview
+// component (the vert offsets and bone transforms are baked in the space of each part)
+static void GetBakeMeshComponents(UDebugSkelMeshComponent* PreviewComponent, const bool bMergeFollowers, TArray <USkinnedMeshComponent*>& OutComponents)
+{
+	OutComponents.Reset();
+	OutComponents.Add(PreviewComponent);
 
+	if (!bMergeFollowers) return;
 
-		TArray <FColor> thisLODSkinWeightColor;
-		// Here is where we find the correct grid UVs for this LOD
-		TArray <FVector2D> thisLODGridUVs_Vert, thisLODGridUVs_Bone1, thisLODGridUVs_Bone2;
+	TMap <FName, FTransform> RefPose;
+	AddRefPoseBones(PreviewComponent->SkeletalMesh->RefSkeleton, RefPose);
 
-		thisLODGridUVs_Bone1.SetNum(FinalVertices.Num());
-		thisLODGridUVs_Bone2.SetNum(FinalVertices.Num());
-		thisLODSkinWeightColor.SetNum(FinalVertices.Num());
+	FString Skipped;
+	for (const TWeakObjectPtr<USkinnedMeshComponent>& Follower : PreviewComponent->GetSlavePoseComponents())
+	{
+		USkinnedMeshComponent* Component = Follower.Get();
+		if ((Component == NULL) || (Component->SkeletalMesh == NULL) || (Component->MeshObject == NULL) || !Component->IsVisible()) continue;
 
-		if (OverallLODIndex == AnimMeshLOD)
+		const FString MeshName = Component->SkeletalMesh->GetName();
+
+		// Bone columns are shared, every part has to index the same skeleton
+		if (Component->SkeletalMesh->Skeleton != PreviewComponent->SkeletalMesh->Skeleton)
 		{
-			thisLODGridUVs_Vert = GridUVs_Vert;
+			Skipped += FString::Printf(TEXT("\n%s: uses a different skeleton"), *MeshName);
+			continue;
 		}
-		else
-		{
-			// Here we search
-			thisLODGridUVs_Vert.SetNum(FinalVertices.Num());
-
-			for (int32 o = 0; o < FinalVertices.Num(); o++)
-			{
-				const FVector Pos = FinalVertices[o].Position;
-				float Lowest = MAX_FLT;
-				int32 WinnerID = INDEX_NONE;
-
-				for (int32 u = 0; u < UniqueSourceID.Num(); u++)
-				{
-					const FVector TargetPos = AnimMeshFinalVertices[UniqueSourceID[u]].Position;
 
-					const float Dist = FVector::Dist(Pos, TargetPos);
-					if (Dist < Lowest)
-					{
-						Lowest = Dist;
-						WinnerID = UniqueSourceID[u];
-					}
-				}
-
-				check(WinnerID != INDEX_NONE);
-
-				thisLODGridUVs_Vert[o] = GridUVs_Vert[WinnerID];
-			}
+		const FTransform PartToPreview = Component->GetComponentTransform().GetRelativeTransform(PreviewComponent->GetComponentTransform());
+		if (!PartToPreview.Equals(FTransform::Identity, KINDA_SMALL_NUMBER))
+		{
+			Skipped += FString::Printf(TEXT("\n%s: is moved relative to the preview mesh"), *MeshName);
+			continue;
 		}
 
-
-		FSkeletalMeshModel* Resource = InSkinnedMeshComponent->SkeletalMesh->GetImportedModel();
-		FSkeletalMeshLODRenderData& LODData = SkeletalMeshRenderData.LODRenderData[LODIndexRead];
-
+		const FReferenceSkeleton& RefSkeleton = Component->SkeletalMesh->RefSkeleton;
+		bool bSameRefPose = true;
+		for (int32 B = 0; (B < RefSkeleton.GetNum()) && bSameRefPose; B++)
 		{
-			const FSkinWeightVertexBuffer& SkinWeightVertexBuffer = *LODData.GetSkinWeightVertexBuffer();
-
-			auto SkinData = LODData.GetSkinWeightVertexBuffer();
-			check(SkinData->GetNumVertices() == FinalVertices.Num());
-
-			for (int32 s = 0; s < (int32)SkinData->GetNumVertices(); s++)
-			{
-				int32 SectionIndex;
-				int32 VertIndex;
-				LODData.GetSectionFromVertexIndex(s, SectionIndex, VertIndex);
-				check(SectionIndex < LODData.RenderSections.Num());
-				const FSkelMeshRenderSection& Section = LODData.RenderSections[SectionIndex];
-				const auto& SoftVert = Resource->LODModels[LODIndexRead].Sections[SectionIndex].SoftVertices[VertIndex];
-
-				uint32 InfluenceBones[4] = {
-						SoftVert.InfluenceBones[0],
-						SoftVert.InfluenceBones[1],
-						SoftVert.InfluenceBones[2],
-						SoftVert.InfluenceBones[3]
-				};
-
-				uint8 InfluenceWeights[4] = {
-						SoftVert.InfluenceWeights[0],
-						SoftVert.InfluenceWeights[1],
-						SoftVert.InfluenceWeights[2],
-						SoftVert.InfluenceWeights[3]
-				};
-
-				const float Sum =
-					((float)InfluenceWeights[0] / 255.f) + ((float)InfluenceWeights[1] / 255.f)
-					+ ((float)InfluenceWeights[2] / 255.f) + ((float)InfluenceWeights[3] / 255.f);
-				const float Rest = 1.f - Sum;
-
-				FLinearColor W = FLinearColor(
-					((float)InfluenceWeights[0] / 255.f) + Rest,
-					((float)InfluenceWeights[1] / 255.f),
-					((float)InfluenceWeights[2] / 255.f),
-					((float)InfluenceWeights[3] / 255.f));
-
-
-				thisLODSkinWeightColor[s] = W.ToFColor(false);
-
-				{
-					check(Section.BoneMap.IsValidIndex(InfluenceBones[0]));
-					check(Section.BoneMap.IsValidIndex(InfluenceBones[1]));
-					check(Section.BoneMap.IsValidIndex(InfluenceBones[2]));
-					check(Section.BoneMap.IsValidIndex(InfluenceBones[3]));
-
-					const int32 
-						Bone0 = GlobalRefSkeleton.FindBoneIndex(RefSkeleton.GetBoneName(Section.BoneMap[InfluenceBones[0]])),
-						Bone1 = GlobalRefSkeleton.FindBoneIndex(RefSkeleton.GetBoneName(Section.BoneMap[InfluenceBones[1]])),
-						Bone2 = GlobalRefSkeleton.FindBoneIndex(RefSkeleton.GetBoneName(Section.BoneMap[InfluenceBones[2]])),
-						Bone3 = GlobalRefSkeleton.FindBoneIndex(RefSkeleton.GetBoneName(Section.BoneMap[InfluenceBones[3]]));
-
-					
-					checkf(GridUVs_Bone.IsValidIndex(Bone0), TEXT("NUMY %i || %i"),
-						GridUVs_Bone.Num(), LODData.ActiveBoneIndices.Num());
-					checkf(GridUVs_Bone.IsValidIndex(Bone1), TEXT("NUMY %i || %i"),
-						GridUVs_Bone.Num(), LODData.ActiveBoneIndices.Num());
-					checkf(GridUVs_Bone.IsValidIndex(Bone2), TEXT("NUMY %i || %i"),
-						GridUVs_Bone.Num(), LODData.ActiveBoneIndices.Num());
-					checkf(GridUVs_Bone.IsValidIndex(Bone3), TEXT("NUMY %i || %i"),
-						GridUVs_Bone.Num(), LODData.ActiveBoneIndices.Num());
-
-					
-					thisLODGridUVs_Bone1[s] = FVector2D(
-						GridUVs_Bone[Bone0].X,
-						GridUVs_Bone[Bone1].X);
-					thisLODGridUVs_Bone2[s] = FVector2D(
-						GridUVs_Bone[Bone2].X,
-						GridUVs_Bone[Bone3].X);
-				}
-			}
+			const FTransform* Shared = RefPose.Find(RefSkeleton.GetBoneName(B));
+			bSameRefPose = (Shared == NULL) || Shared->Equals(FAnimationRuntime::GetComponentSpaceTransformRefPose(RefSkeleton, B), KINDA_SMALL_NUMBER);
+		}
+		if (!bSameRefPose)
+		{
+			Skipped += FString::Printf(TEXT("\n%s: its ref pose differs from the meshes before it"), *MeshName);
+			continue;
 		}
 
-		UVs_VertAnim.Add(thisLODGridUVs_Vert);
-		UVs_BoneAnim1.Add(thisLODGridUVs_Bone1);
-		UVs_BoneAnim2.Add(thisLODGridUVs_Bone2);
-		Colors_BoneAnim.Add(thisLODSkinWeightColor);
+		AddRefPoseBones(RefSkeleton, RefPose);
+		OutComponents.Add(Component);
+	}
+
+	if (!Skipped.IsEmpty())
+	{
+		UE_LOG(LogVertexAnimToolset, Warning, TEXT("VAT bake skipped follower meshes:%s"), *Skipped);
+		FMessageDialog::Open(EAppMsgType::Ok, FText::Format(
+			LOCTEXT("SkippedFollowerMeshes", "These follower meshes are not merged into the bake:{0}"), FText::FromString(Skipped)));
 	}
 }
 
+static int32 GetPartLOD(const USkinnedMeshComponent* Component, const int32 LODIndex)
+{
+	return FMath::Min(LODIndex, Component->GetNumLODs() - 1);
+}
 
-static void QuatSave(FQuat& Q)
+// CPU skinned verts of all parts for one LOD, OutFirstVerts holds the first merged vert of every part followed by the total
+static void GetMergedCPUSkinnedVertices(const TArray <USkinnedMeshComponent*>& Components, const int32 LODIndex,
+	TArray <FFinalSkinVertex>& OutVerts, TArray <int32>& OutFirstVerts)
 {
-	// Make sure we have a non null SquareSum. It shouldn't happen with a quaternion, but better be safe.
-	if (Q.SizeSquared() <= SMALL_NUMBER)
+	OutVerts.Reset();
+	OutFirstVerts.Reset(Components.Num() + 1);
+
+	for (USkinnedMeshComponent* Component : Components)
 	{
-		Q = FQuat::Identity;
+		OutFirstVerts.Add(OutVerts.Num());
+
+		TArray <FFinalSkinVertex> PartVerts;
+		Component->GetCPUSkinnedVertices(PartVerts, GetPartLOD(Component, LODIndex));
+		OutVerts.Append(PartVerts);
 	}
-	else
+
+	OutFirstVerts.Add(OutVerts.Num());
+}
+
+// Index buffers of all parts for one LOD, offset to the merged verts of GetMergedCPUSkinnedVertices
+static void GetMergedIndexBuffer(const TArray <USkinnedMeshComponent*>& Components, const int32 LODIndex, TArray <uint32>& OutIndices)
+{
+	OutIndices.Reset();
+
+	uint32 FirstVert = 0;
+	for (USkinnedMeshComponent* Component : Components)
 	{
-		// All transmitted quaternions *MUST BE* unit quaternions, in which case we can deduce the value of W.
-		if (!ensure(Q.IsNormalized()))
-		{
-			Q.Normalize();
-		}
+		const FSkeletalMeshLODRenderData& LODData = Component->MeshObject->GetSkeletalMeshRenderData().LODRenderData[GetPartLOD(Component, LODIndex)];
+
+		TArray <uint32> PartIndices;
+		LODData.MultiSizeIndexContainer.GetIndexBuffer(PartIndices);
+		for (const uint32 Index : PartIndices) OutIndices.Add(FirstVert + Index);
+
+		FirstVert += LODData.GetNumVertices();
 	}
 }
 
-void GatherAndBakeAllAnimVertData(
-	UVertexAnimProfile* Profile,
-	UDebugSkelMeshComponent* PreviewComponent,
-	const TArray <int32>& UniqueSourceIDs,
-	TArray <FVector4>& OutGridVertPos, 
-	TArray <FVector4>& OutGridVertNormal,
-	TArray <FVector4>& OutGridBonePos,
-	TArray <FVector4>& OutGridBoneRot)
+// Share of vert anim texture fetches missing a small LRU cache of 64 byte lines when the verts are shaded in index buffer order.
+// Lines run along a texture row, a CPU stand-in for the texture cache hit rate of the vertex shader
+static float SimulateVertFetchMissRate(const UVertexAnimProfile* Profile, const TArray <uint32>& Indices, const TArray <FVector2D>& UVs)
 {
-	bool bCachedCPUSkinning = false;
-	constexpr bool bRecreateRenderStateImmediately = true;
-	// 1 switch to CPU skinning
-	{
-		const int32 InLODIndex = 0;
-		{
-			if (USkinnedMeshComponent* MasterPoseComponentPtr = PreviewComponent->MasterPoseComponent.Get())
-			{
-				MasterPoseComponentPtr->SetForcedLOD(InLODIndex + 1);
-				MasterPoseComponentPtr->UpdateLODStatus();
-				MasterPoseComponentPtr->RefreshBoneTransforms(nullptr);
-			}
-			else
-			{
-				PreviewComponent->SetForcedLOD(InLODIndex + 1);
-				PreviewComponent->UpdateLODStatus();
-				PreviewComponent->RefreshBoneTransforms(nullptr);
-			}
+	const int32 TexelsPerLine = 64 / sizeof(FFloat16Color);
+	const int32 NumCacheLines = 32;
 
-			// switch to CPU skinning
-			bCachedCPUSkinning = PreviewComponent->GetCPUSkinningEnabled();
+	// Most recently used first
+	TArray <int32, TInlineAllocator<NumCacheLines>> Cache;
+	int32 Fetches = 0;
+	int32 Misses = 0;
 
-			PreviewComponent->SetCPUSkinningEnabled(true, bRecreateRenderStateImmediately);
+	for (const uint32 Index : Indices)
+	{
+		const int32 Texel = UVs.IsValidIndex(Index) ? FVertexAnimDecoder::UVToVertexIndex(Profile, UVs[Index]) : INDEX_NONE;
+		if (Texel == INDEX_NONE) continue;
 
-			check(PreviewComponent->MeshObject);
-			check(PreviewComponent->MeshObject->IsCPUSkinned());
+		const int32 Line = Texel / TexelsPerLine;
+		const int32 Found = Cache.Find(Line);
+		if (Found == INDEX_NONE)
+		{
+			Misses++;
+			if (Cache.Num() == NumCacheLines) Cache.Pop(false);
+		}
+		else
+		{
+			Cache.RemoveAt(Found, 1, false);
 		}
+
+		Cache.Insert(Line, 0);
+		Fetches++;
 	}
 
-	// 2 Make Sure it in ref pose
-	PreviewComponent->EnablePreview(true, NULL);
-	PreviewComponent->RefreshBoneTransforms(nullptr);
-	PreviewComponent->ClearMotionVector();
-	FlushRenderingCommands();
+	return Fetches ? (float)Misses / Fetches : 0.f;
+}
 
+// Hybrid vert mask of all parts for one LOD, empty when the profile is not a hybrid bake
+static void GetMergedHybridVertMask(const UVertexAnimProfile* Profile, const TArray <USkinnedMeshComponent*>& Components, const int32 LODIndex,
+	TArray <bool>& OutMask)
+{
+	OutMask.Reset();
 
-	TArray <FFinalSkinVertex> RefPoseFinalVerts = static_cast<FSkeletalMeshObjectCPUSkin*>(PreviewComponent->MeshObject)->GetCachedFinalVertices();
+	if (!Profile->HybridBake) return;
 
-	TArray <FVector4> GridVertPos;
-	TArray <FVector4> GridVertNormal;
+	for (USkinnedMeshComponent* Component : Components)
+	{
+		TArray <bool> PartMask;
+		CalcHybridVertMask(Profile, Component->SkeletalMesh, GetPartLOD(Component, LODIndex), PartMask);
+		OutMask.Append(PartMask);
+	}
+}
 
-	TArray <FVector4> GridBonePos;
-	TArray <FVector4> GridBoneRot;
+// First unique vert of every part followed by the total, unique verts are in ascending merged vert order and never span two parts
+static void SplitUniqueVertsByPart(const TArray <int32>& UniqueSourceIDs, const TArray <int32>& FirstVerts, TArray <int32>& OutFirstUniques)
+{
+	OutFirstUniques.Reset(FirstVerts.Num());
 
-	float MaxValueOffset = 0.f;
+	int32 u = 0;
+	for (int32 Part = 0; Part < FirstVerts.Num() - 1; Part++)
+	{
+		OutFirstUniques.Add(u);
+		while ((u < UniqueSourceIDs.Num()) && (UniqueSourceIDs[u] < FirstVerts[Part + 1])) u++;
+	}
 
-	float MaxValuePosBone = 0.f;
+	OutFirstUniques.Add(UniqueSourceIDs.Num());
+}
 
-	const int32 PerFrameArrayNum_Vert = Profile->OverrideSize_Vert.X * Profile->RowsPerFrame_Vert;
-	const int32 PerFrameArrayNum_Bone = Profile->OverrideSize_Bone.X;
+// Bone grid UVs and skin weight colors of the verts of one part LOD, the bones are looked up by name in the skeleton
+// and GridUVs_Bone holds the UV of each bone texture column
+static void MapPartBoneUVs(
+	USkinnedMeshComponent* InSkinnedMeshComponent, const int32 LODIndexRead,
+	const FReferenceSkeleton& GlobalRefSkeleton, const TArray <int32>& GlobalToColumn, const TArray <FVector2D>& GridUVs_Bone,
+	TArrayView <FVector2D> thisLODGridUVs_Bone1, TArrayView <FVector2D> thisLODGridUVs_Bone2, TArrayView <FColor> thisLODSkinWeightColor)
+{
+	const auto& RefSkeleton = InSkinnedMeshComponent->SkeletalMesh->RefSkeleton;
 
-	
+	FSkeletalMeshModel* Resource = InSkinnedMeshComponent->SkeletalMesh->GetImportedModel();
+	FSkeletalMeshLODRenderData& LODData = InSkinnedMeshComponent->MeshObject->GetSkeletalMeshRenderData().LODRenderData[LODIndexRead];
 
-	TArray <FVector4> ZeroedPos;
-	ZeroedPos.SetNumZeroed(PerFrameArrayNum_Vert);
-	TArray <FVector4> ZeroedNorm;
-	ZeroedNorm.SetNumZeroed(PerFrameArrayNum_Vert);
+	const FSkinWeightVertexBuffer& SkinWeightVertexBuffer = *LODData.GetSkinWeightVertexBuffer();
 
-	// YOW, need different sizes for vert and bone textures.
-	TArray <FVector4> ZeroedBonePos;
-	ZeroedBonePos.SetNumZeroed(PerFrameArrayNum_Bone);
-	TArray <FVector4> ZeroedBoneRot;
-	ZeroedBoneRot.SetNumZeroed(PerFrameArrayNum_Bone);
+	auto SkinData = LODData.GetSkinWeightVertexBuffer();
+	check(SkinData->GetNumVertices() == thisLODSkinWeightColor.Num());
 
-	FSkeletalMeshRenderData& SkeletalMeshRenderData = PreviewComponent->MeshObject->GetSkeletalMeshRenderData();
-	FSkeletalMeshLODRenderData& LODData = SkeletalMeshRenderData.LODRenderData[0];
-	const auto& ActiveBoneIndices = LODData.ActiveBoneIndices;
-	TArray <FMatrix> RefToLocal;
+	auto FindColumn = [&RefSkeleton, &GlobalRefSkeleton, &GlobalToColumn](const int32 MeshBone)
+	{
+		const int32 GlobalBone = GlobalRefSkeleton.FindBoneIndex(RefSkeleton.GetBoneName(MeshBone));
+		return GlobalToColumn.IsValidIndex(GlobalBone) ? GlobalToColumn[GlobalBone] : INDEX_NONE;
+	};
 
-	// 3 Store Values
-	// Vert Anim
-	if (Profile->Anims_Vert.Num())
+	for (int32 s = 0; s < (int32)SkinData->GetNumVertices(); s++)
 	{
-		for (int32 i = 0; i < Profile->Anims_Vert.Num(); i++)
+		int32 SectionIndex;
+		int32 VertIndex;
+		LODData.GetSectionFromVertexIndex(s, SectionIndex, VertIndex);
+		check(SectionIndex < LODData.RenderSections.Num());
+		const FSkelMeshRenderSection& Section = LODData.RenderSections[SectionIndex];
+		const auto& SoftVert = Resource->LODModels[LODIndexRead].Sections[SectionIndex].SoftVertices[VertIndex];
+
+		uint32 InfluenceBones[4] = {
+				SoftVert.InfluenceBones[0],
+				SoftVert.InfluenceBones[1],
+				SoftVert.InfluenceBones[2],
+				SoftVert.InfluenceBones[3]
+		};
+
+		uint8 InfluenceWeights[4] = {
+				SoftVert.InfluenceWeights[0],
+				SoftVert.InfluenceWeights[1],
+				SoftVert.InfluenceWeights[2],
+				SoftVert.InfluenceWeights[3]
+		};
+
+		const float Sum =
+			((float)InfluenceWeights[0] / 255.f) + ((float)InfluenceWeights[1] / 255.f)
+			+ ((float)InfluenceWeights[2] / 255.f) + ((float)InfluenceWeights[3] / 255.f);
+		const float Rest = 1.f - Sum;
+
+		FLinearColor W = FLinearColor(
+			((float)InfluenceWeights[0] / 255.f) + Rest,
+			((float)InfluenceWeights[1] / 255.f),
+			((float)InfluenceWeights[2] / 255.f),
+			((float)InfluenceWeights[3] / 255.f));
+
+
+		thisLODSkinWeightColor[s] = W.ToFColor(false);
+
 		{
-			PreviewComponent->EnablePreview(true, Profile->Anims_Vert[i].SequenceRef);
-			UAnimSingleNodeInstance* SingleNodeInstance = PreviewComponent->GetSingleNodeInstance();
+			check(Section.BoneMap.IsValidIndex(InfluenceBones[0]));
+			check(Section.BoneMap.IsValidIndex(InfluenceBones[1]));
+			check(Section.BoneMap.IsValidIndex(InfluenceBones[2]));
+			check(Section.BoneMap.IsValidIndex(InfluenceBones[3]));
 
-			const float Length = SingleNodeInstance->GetLength();
-			const float Step_Vert = Length / Profile->Anims_Vert[i].NumFrames;
+			const int32 
+				Bone0 = FindColumn(Section.BoneMap[InfluenceBones[0]]),
+				Bone1 = FindColumn(Section.BoneMap[InfluenceBones[1]]),
+				Bone2 = FindColumn(Section.BoneMap[InfluenceBones[2]]),
+				Bone3 = FindColumn(Section.BoneMap[InfluenceBones[3]]);
 
-			Profile->Anims_Vert[i].Speed_Generated = 1.f / Length;
-			Profile->Anims_Vert[i].AnimStart_Generated = Profile->CalcStartHeightOfAnim_Vert(i);
+			
+			checkf(GridUVs_Bone.IsValidIndex(Bone0), TEXT("NUMY %i || %i"),
+				GridUVs_Bone.Num(), LODData.ActiveBoneIndices.Num());
+			checkf(GridUVs_Bone.IsValidIndex(Bone1), TEXT("NUMY %i || %i"),
+				GridUVs_Bone.Num(), LODData.ActiveBoneIndices.Num());
+			checkf(GridUVs_Bone.IsValidIndex(Bone2), TEXT("NUMY %i || %i"),
+				GridUVs_Bone.Num(), LODData.ActiveBoneIndices.Num());
+			checkf(GridUVs_Bone.IsValidIndex(Bone3), TEXT("NUMY %i || %i"),
+				GridUVs_Bone.Num(), LODData.ActiveBoneIndices.Num());
+
+			
+			thisLODGridUVs_Bone1[s] = FVector2D(
+				GridUVs_Bone[Bone0].X,
+				GridUVs_Bone[Bone1].X);
+			thisLODGridUVs_Bone2[s] = FVector2D(
+				GridUVs_Bone[Bone2].X,
+				GridUVs_Bone[Bone3].X);
+		}
+	}
+}
+
+// Appends the skeleton index of the active bones of a mesh LOD (the bones its verts are skinned to, with their parents)
+// missing from InOutColumnBones, in skeleton order so parents stay before their children
+static void AddActiveBones(
+	const USkeletalMesh* Mesh, const int32 LODIndex, const FReferenceSkeleton& GlobalRefSkeleton, TArray <int32>& InOutColumnBones)
+{
+	const FSkeletalMeshLODRenderData& LODData = Mesh->GetResourceForRendering()->LODRenderData[LODIndex];
+
+	TArray <int32> Added;
+	for (const FBoneIndexType MeshBone : LODData.ActiveBoneIndices)
+	{
+		const int32 GlobalBone = GlobalRefSkeleton.FindBoneIndex(Mesh->RefSkeleton.GetBoneName(MeshBone));
+		if ((GlobalBone != INDEX_NONE) && !InOutColumnBones.Contains(GlobalBone)) Added.AddUnique(GlobalBone);
+	}
+
+	Added.Sort();
+	InOutColumnBones.Append(Added);
+}
+
+static void AddMaskBones(const UVertexAnimProfile* Profile, const FReferenceSkeleton& GlobalRefSkeleton, TArray <int32>& InOutColumnBones)
+{
+	for (const FName& BoneName : Profile->BoneMask)
+	{
+		const int32 GlobalBone = GlobalRefSkeleton.FindBoneIndex(BoneName);
+		if (GlobalBone != INDEX_NONE) InOutColumnBones.AddUnique(GlobalBone);
+	}
+
+	// Mirrored playback reads the other bone of a pair
+	for (const FVAMirrorBonePair& Pair : Profile->MirrorBonePairs)
+	{
+		const int32 BoneA = GlobalRefSkeleton.FindBoneIndex(Pair.BoneA);
+		const int32 BoneB = GlobalRefSkeleton.FindBoneIndex(Pair.BoneB);
+		if ((BoneA == INDEX_NONE) || (BoneB == INDEX_NONE)) continue;
+
+		if (InOutColumnBones.Contains(BoneA)) InOutColumnBones.AddUnique(BoneB);
+		else if (InOutColumnBones.Contains(BoneB)) InOutColumnBones.AddUnique(BoneA);
+	}
+
+	// Override layers follow the parent of their layer bones
+	for (const FVABoneLayerData& Layer : Profile->Layers_Bone)
+	{
+		for (const FName& BoneName : Layer.LayerBones)
+		{
+			const int32 GlobalBone = GlobalRefSkeleton.FindBoneIndex(BoneName);
+			const int32 Parent = (GlobalBone != INDEX_NONE) ? GlobalRefSkeleton.GetParentIndex(GlobalBone) : INDEX_NONE;
+			if (Parent != INDEX_NONE) InOutColumnBones.AddUnique(Parent);
+		}
+	}
+}
+
+// Skeleton bone of each bone texture column, also sets BoneNames_Generated.
+// The columns a shared bone asset already has keep their place since other profiles read them
+static void MapBoneColumns(
+	UVertexAnimProfile* InProfile, const TArray <USkinnedMeshComponent*>& InComponents, const FReferenceSkeleton& GlobalRefSkeleton,
+	const int32 NumLODs, TArray <int32>& OutColumnBones)
+{
+	OutColumnBones.Reset();
+
+	const UVertexAnimBoneAsset* SharedBoneAnim = InProfile->SharedBoneAnim;
+	if (SharedBoneAnim && (SharedBoneAnim->Skeleton == InComponents[0]->SkeletalMesh->Skeleton))
+	{
+		for (const FName& BoneName : SharedBoneAnim->BoneNames_Generated)
+		{
+			const int32 GlobalBone = GlobalRefSkeleton.FindBoneIndex(BoneName);
+			if (GlobalBone != INDEX_NONE) OutColumnBones.AddUnique(GlobalBone);
+		}
+	}
+
+	if (InProfile->ActiveBonesOnly)
+	{
+		// Lowest LOD first so the bones of every LOD are the first columns
+		for (int32 LOD = NumLODs - 1; LOD >= 0; LOD--)
+		{
+			for (USkinnedMeshComponent* Component : InComponents)
+			{
+				AddActiveBones(Component->SkeletalMesh, GetPartLOD(Component, LOD), GlobalRefSkeleton, OutColumnBones);
+			}
+		}
+
+		AddMaskBones(InProfile, GlobalRefSkeleton, OutColumnBones);
+	}
+	else
+	{
+		for (int32 B = 0; B < GlobalRefSkeleton.GetNum(); B++)
+		{
+			OutColumnBones.AddUnique(B);
+		}
+	}
+
+	InProfile->BoneNames_Generated.SetNum(OutColumnBones.Num());
+	for (int32 C = 0; C < OutColumnBones.Num(); C++)
+	{
+		InProfile->BoneNames_Generated[C] = GlobalRefSkeleton.GetBoneName(OutColumnBones[C]);
+	}
+}
+
+// Layer columns of every bone layer, the columns of its layer bones and their children, with the column of the parent of the
+// topmost layer bone above them. A frame of a layer holds only its columns, as many frames side by side as fit the bone texture width
+static void MapBoneLayers(UVertexAnimProfile* InProfile, const FReferenceSkeleton& GlobalRefSkeleton, const TArray <int32>& ColumnBones)
+{
+	FIntPoint TextureSize;
+	InProfile->CalcLayout_Bone(ColumnBones.Num(), TextureSize);
+
+	for (FVABoneLayerData& Layer : InProfile->Layers_Bone)
+	{
+		Layer.Columns_Generated.Reset();
+		Layer.AttachColumns_Generated.Reset();
+
+		TArray <int32> LayerBones;
+		for (const FName& BoneName : Layer.LayerBones)
+		{
+			const int32 GlobalBone = GlobalRefSkeleton.FindBoneIndex(BoneName);
+			if (GlobalBone != INDEX_NONE) LayerBones.AddUnique(GlobalBone);
+		}
+
+		for (int32 C = 0; C < ColumnBones.Num(); C++)
+		{
+			int32 LayerRoot = INDEX_NONE;
+			for (int32 B = ColumnBones[C]; B != INDEX_NONE; B = GlobalRefSkeleton.GetParentIndex(B))
+			{
+				if (LayerBones.Contains(B)) LayerRoot = B;
+			}
+			if (LayerRoot == INDEX_NONE) continue;
+
+			const int32 Parent = GlobalRefSkeleton.GetParentIndex(LayerRoot);
+			Layer.Columns_Generated.Add(C);
+			Layer.AttachColumns_Generated.Add((Parent != INDEX_NONE) ? ColumnBones.Find(Parent) : INDEX_NONE);
+		}
+
+		Layer.FramesPerRow_Generated = Layer.Columns_Generated.Num() ? FMath::Max(TextureSize.X / Layer.Columns_Generated.Num(), 1) : 0;
+	}
+}
+
+static void SkinnedMeshVATData(
+	const TArray <USkinnedMeshComponent*>& InComponents,
+	UVertexAnimProfile* InProfile,
+	TArray <int32>& UniqueSourceID,
+	TArray <TArray <FVector2D>>& UVs_VertAnim,
+	TArray <TArray <FVector2D>>& UVs_BoneAnim1, 
+	TArray <TArray <FVector2D>>& UVs_BoneAnim2,
+	TArray <TArray <FColor>>& Colors_BoneAnim)
+{
+	UniqueSourceID.Empty();
+	UVs_VertAnim.Empty();
+	UVs_BoneAnim1.Empty();
+	UVs_BoneAnim2.Empty();
+	Colors_BoneAnim.Empty();
+
+	// The merged mesh has the LODs of the part with the most
+	int32 NumLODs = 0;
+	for (USkinnedMeshComponent* Component : InComponents)
+	{
+		NumLODs = FMath::Max(NumLODs, Component->GetNumLODs());
+	}
+
+	const auto& GlobalRefSkeleton = InComponents[0]->SkeletalMesh->Skeleton->GetReferenceSkeleton();
+
+	TArray <FVector2D> GridUVs_Vert;
+	TArray <FVector2D> GridUVs_Bone;
+
+	TArray<FFinalSkinVertex> AnimMeshFinalVertices;
+	TArray <int32> AnimMeshFirstVerts;
+	TArray <int32> AnimMeshFirstUniques;
+	int32 AnimMeshLOD = 0;
+
+
+	int32 UVVertStart = -1;
+	int32 UVBoneStart = -2;
+
+	TArray <int32> GlobalToColumn;
+
+	{
+		TArray <int32> ColumnBones;
+		MapBoneColumns(InProfile, InComponents, GlobalRefSkeleton, NumLODs, ColumnBones);
+		// The layer rows are part of the bone texture height
+		MapBoneLayers(InProfile, GlobalRefSkeleton, ColumnBones);
+		MapActiveBones(InProfile, ColumnBones.Num(), GridUVs_Bone);
+
+		GlobalToColumn.Init(INDEX_NONE, GlobalRefSkeleton.GetNum());
+		for (int32 C = 0; C < ColumnBones.Num(); C++)
+		{
+			GlobalToColumn[ColumnBones[C]] = C;
+		}
+
+		GetMergedCPUSkinnedVertices(InComponents, AnimMeshLOD, AnimMeshFinalVertices, AnimMeshFirstVerts);
+		TArray <bool> AnimMeshMask;
+		GetMergedHybridVertMask(InProfile, InComponents, AnimMeshLOD, AnimMeshMask);
+		TArray <uint32> AnimMeshIndices;
+		if (InProfile->VertOrder == EVAVertOrder::IndexBuffer) GetMergedIndexBuffer(InComponents, AnimMeshLOD, AnimMeshIndices);
+		MapSkinVerts(InProfile, AnimMeshFinalVertices, UniqueSourceID, GridUVs_Vert, AnimMeshFirstVerts, AnimMeshMask, AnimMeshIndices);
+		SplitUniqueVertsByPart(UniqueSourceID, AnimMeshFirstVerts, AnimMeshFirstUniques);
+
+		// VAT channels go after the UVs of the part with the most
+		int32 UVChannelStart = 0;
+		for (USkinnedMeshComponent* Component : InComponents)
+		{
+			FSkeletalMeshLODRenderData& LODData = Component->MeshObject->GetSkeletalMeshRenderData().LODRenderData[0];
+			UVChannelStart = FMath::Max(UVChannelStart, (int32)LODData.StaticVertexBuffers.StaticMeshVertexBuffer.GetNumTexCoords());
+		}
+
+		// Vertex ids take the Y of the bone anim channel, which only the full skinning uses
+		const bool bVertIdInBoneUV = InProfile->VertexIdAddressing && InProfile->Anims_Vert.Num() && InProfile->Anims_Bone.Num() &&
+			!InProfile->FullBoneSkinning;
+
+		UVVertStart = InProfile->Anims_Vert.Num() ? UVChannelStart : -1;
+		UVBoneStart =
+			InProfile->Anims_Bone.Num() ? ((InProfile->Anims_Vert.Num() && !bVertIdInBoneUV) ? UVChannelStart + 1 : UVChannelStart) : -2;
+		if (bVertIdInBoneUV) UVVertStart = UVBoneStart;
+		InProfile->UVChannel_VertAnim = UVVertStart;
+		InProfile->UVComponent_VertAnim = bVertIdInBoneUV ? 1 : 0;
+		InProfile->UVChannel_BoneAnim = UVBoneStart;
+		InProfile->UVChannel_BoneAnim_Full = ((UVBoneStart >= 0) && InProfile->FullBoneSkinning) ? UVBoneStart + 1 : -1;
+	}
+
+
+	for (int32 OverallLODIndex = 0; OverallLODIndex < NumLODs; OverallLODIndex++)
+	{
+		// Get the CPU skinned verts of all parts for this LOD
+		TArray<FFinalSkinVertex> FinalVertices;
+		TArray <int32> FirstVerts;
+		GetMergedCPUSkinnedVertices(InComponents, OverallLODIndex, FinalVertices, FirstVerts);
+
+
+		TArray <FColor> thisLODSkinWeightColor;
+		// Here is where we find the correct grid UVs for this LOD
+		TArray <FVector2D> thisLODGridUVs_Vert, thisLODGridUVs_Bone1, thisLODGridUVs_Bone2;
+
+		thisLODGridUVs_Bone1.SetNum(FinalVertices.Num());
+		thisLODGridUVs_Bone2.SetNum(FinalVertices.Num());
+		thisLODSkinWeightColor.SetNum(FinalVertices.Num());
+
+		if (OverallLODIndex == AnimMeshLOD)
+		{
+			thisLODGridUVs_Vert = GridUVs_Vert;
+		}
+		else
+		{
+			// The LOD has its own hybrid mask, masked verts still only snap to masked verts of the anim mesh LOD
+			TArray <bool> LODMask;
+			GetMergedHybridVertMask(InProfile, InComponents, OverallLODIndex, LODMask);
+
+			// Here we search, part by part so a vert never snaps to another part
+			for (int32 Part = 0; Part < InComponents.Num(); Part++)
+			{
+				const int32 NumPartVerts = FirstVerts[Part + 1] - FirstVerts[Part];
+
+				MapLODVertsToGrid(
+					TArrayView <const FFinalSkinVertex>(FinalVertices.GetData() + FirstVerts[Part], NumPartVerts),
+					AnimMeshFinalVertices,
+					TArrayView <const int32>(UniqueSourceID.GetData() + AnimMeshFirstUniques[Part], AnimMeshFirstUniques[Part + 1] - AnimMeshFirstUniques[Part]),
+					GridUVs_Vert, thisLODGridUVs_Vert,
+					LODMask.Num() ? TArrayView <const bool>(LODMask.GetData() + FirstVerts[Part], NumPartVerts) : TArrayView <const bool>());
+			}
+		}
+
+		// Every LOD addresses the full bone textures, nothing binds the narrower textures of a reduced bone set to its LODs yet.
+		// The set columns are the first columns of the full textures, so the set textures only need the material side
+		for (int32 Part = 0; Part < InComponents.Num(); Part++)
+		{
+			const int32 FirstVert = FirstVerts[Part];
+			const int32 NumPartVerts = FirstVerts[Part + 1] - FirstVert;
+
+			MapPartBoneUVs(InComponents[Part], GetPartLOD(InComponents[Part], OverallLODIndex), GlobalRefSkeleton, GlobalToColumn,
+				GridUVs_Bone,
+				TArrayView <FVector2D>(thisLODGridUVs_Bone1.GetData() + FirstVert, NumPartVerts),
+				TArrayView <FVector2D>(thisLODGridUVs_Bone2.GetData() + FirstVert, NumPartVerts),
+				TArrayView <FColor>(thisLODSkinWeightColor.GetData() + FirstVert, NumPartVerts));
+		}
+
+		UVs_VertAnim.Add(thisLODGridUVs_Vert);
+		UVs_BoneAnim1.Add(thisLODGridUVs_Bone1);
+		UVs_BoneAnim2.Add(thisLODGridUVs_Bone2);
+		Colors_BoneAnim.Add(thisLODSkinWeightColor);
+	}
+}
+
+
+static void QuatSave(FQuat& Q)
+{
+	// Make sure we have a non null SquareSum. It shouldn't happen with a quaternion, but better be safe.
+	if (Q.SizeSquared() <= SMALL_NUMBER)
+	{
+		Q = FQuat::Identity;
+	}
+	else
+	{
+		// All transmitted quaternions *MUST BE* unit quaternions, in which case we can deduce the value of W.
+		if (!ensure(Q.IsNormalized()))
+		{
+			Q.Normalize();
+		}
+	}
+}
+
+// Index in the skeleton of each bone of the mesh
+static void MapMeshToGlobalBones(const FReferenceSkeleton& RefSkeleton, const FReferenceSkeleton& GlobalRefSkeleton, TArray <int32>& OutMeshToGlobalBone)
+{
+	OutMeshToGlobalBone.SetNum(RefSkeleton.GetNum());
+
+	for (int32 B = 0; B < RefSkeleton.GetNum(); B++)
+	{
+		OutMeshToGlobalBone[B] = GlobalRefSkeleton.FindBoneIndex(RefSkeleton.GetBoneName(B));
+		check(OutMeshToGlobalBone[B] != INDEX_NONE);
+	}
+}
+
+// Bone texture column of each bone of the mesh, INDEX_NONE for bones left out of the bone textures
+static void MapMeshToBoneColumns(const FReferenceSkeleton& RefSkeleton, const UVertexAnimProfile* Profile, TArray <int32>& OutMeshToColumn)
+{
+	OutMeshToColumn.SetNum(RefSkeleton.GetNum());
+
+	for (int32 B = 0; B < RefSkeleton.GetNum(); B++)
+	{
+		OutMeshToColumn[B] = Profile->BoneNames_Generated.IndexOfByKey(RefSkeleton.GetBoneName(B));
+	}
+}
+
+// Ref pose positions and normals of the unique verts, the only ones the per frame deltas read
+static void GatherUniqueVerts(
+	const TArray <FFinalSkinVertex>& SkinVerts, const TArray <int32>& UniqueSourceIDs,
+	TArray <FVector>& OutPositions, TArray <FVector>& OutNormals)
+{
+	OutPositions.SetNumUninitialized(UniqueSourceIDs.Num());
+	OutNormals.SetNumUninitialized(UniqueSourceIDs.Num());
+
+	for (int32 k = 0; k < UniqueSourceIDs.Num(); k++)
+	{
+		const FFinalSkinVertex& Vert = SkinVerts[UniqueSourceIDs[k]];
+		OutPositions[k] = Vert.Position;
+		OutNormals[k] = Vert.TangentZ.ToFVector();
+	}
+}
+
+// Position and normal deltas to the ref pose of the unique verts for one frame, written straight into the frame block of the grid.
+// With bQTangent the absolute tangent frame is stored instead of the normal delta
+static void StoreFrameVertDeltas(
+	const TArray <FFinalSkinVertex>& FinalVerts, const TArray <FVector>& RefPosePositions, const TArray <FVector>& RefPoseNormals,
+	const TArray <int32>& UniqueSourceIDs, TArrayView <FVector4> FramePos, TArrayView <FVector4> FrameNorm, float& MaxValueOffset,
+	const bool bQTangent = false)
+{
+	VAT_SCOPE(StoreFrameVertDeltas);
+
+	for (int32 k = 0; k < UniqueSourceIDs.Num(); k++)
+	{
+		const FFinalSkinVertex& Vert = FinalVerts[UniqueSourceIDs[k]];
+		const FVector Delta = Vert.Position - RefPosePositions[k];
+		MaxValueOffset = FMath::Max(Delta.GetAbsMax(), MaxValueOffset);
+		FramePos[k] = Delta;
+
+		if (bQTangent)
+		{
+			const FQuat Q = FVertexAnimDecoder::EncodeQTangent(Vert.TangentX.ToFVector(), Vert.TangentZ.ToFVector(), Vert.TangentZ.ToFVector4().W);
+			FrameNorm[k] = FVector4(Q.X, Q.Y, Q.Z, Q.W);
+			continue;
+		}
+
+		const FVector DeltaNormal = Vert.TangentZ.ToFVector() - RefPoseNormals[k];
+		FrameNorm[k] = DeltaNormal;
+	}
+}
+
+// Ref pose to animated pose transforms of every mesh bone with a bone texture column for one frame
+static void StoreFrameBoneTransforms(
+	const TArray <FMatrix>& RefToLocal, const TArray <int32>& MeshToColumn,
+	TArray <FVector4>& ZeroedBonePos, TArray <FVector4>& ZeroedBoneRot, float& MaxValuePosBone)
+{
+	VAT_SCOPE(StoreFrameBoneTransforms);
+
+	for (int32 k = 0; k < RefToLocal.Num(); k++)
+	{
+		const int32 GlobalID = MeshToColumn[k];
+		if (GlobalID == INDEX_NONE) continue;
+
+		FVector Pos = RefToLocal[k].GetOrigin();
+		ZeroedBonePos[GlobalID] = Pos;
+
+		MaxValuePosBone = FMath::Max(MaxValuePosBone, Pos.GetAbsMax());
+
+		FQuat Q = RefToLocal[k].ToQuat();
+		QuatSave(Q);
+		ZeroedBoneRot[GlobalID] = FVector4(Q.X, Q.Y, Q.Z, Q.W);
+	}
+}
+
+static FBox CalcSkinVertsBounds(const TArray <FFinalSkinVertex>& SkinVerts)
+{
+	FBox Out(ForceInit);
+
+	for (int32 i = 0; i < SkinVerts.Num(); i++)
+	{
+		Out += SkinVerts[i].Position;
+	}
+
+	return Out;
+}
+
+// Extends the ref pose bounds of the static mesh to cover every baked frame, so instances need no bounds scale
+static void ApplyAnimatedBoundsToStaticMesh(UVertexAnimProfile* Profile)
+{
+	UStaticMesh* StaticMesh = Profile->StaticMesh;
+	const FBox AnimBounds = Profile->CalcAllAnimsBounds();
+
+	if ((StaticMesh == NULL) || !AnimBounds.IsValid) return;
+
+	// GetBoundingBox includes the extensions of a previous bake, clear them to get the bounds of the mesh itself
+	StaticMesh->Modify();
+	StaticMesh->PositiveBoundsExtension = FVector::ZeroVector;
+	StaticMesh->NegativeBoundsExtension = FVector::ZeroVector;
+	StaticMesh->CalculateExtendedBounds();
+	const FBox RefBounds = StaticMesh->GetBoundingBox();
+
+	StaticMesh->PositiveBoundsExtension = (AnimBounds.Max - RefBounds.Max).ComponentMax(FVector::ZeroVector);
+	StaticMesh->NegativeBoundsExtension = (RefBounds.Min - AnimBounds.Min).ComponentMax(FVector::ZeroVector);
+	StaticMesh->CalculateExtendedBounds();
+	StaticMesh->MarkPackageDirty();
+}
+
+static const TArray <FFinalSkinVertex>& GetCachedFinalVerts(USkinnedMeshComponent* Component)
+{
+	return static_cast<FSkeletalMeshObjectCPUSkin*>(Component->MeshObject)->GetCachedFinalVertices();
+}
+
+// Followers are skinned with the bone transforms of the preview component, this sends their new skinned verts
+static void RefreshFollowerMeshes(const TArray <USkinnedMeshComponent*>& Components, const bool bRecreateClothing)
+{
+	for (int32 Part = 1; Part < Components.Num(); Part++)
+	{
+		USkinnedMeshComponent* Component = Components[Part];
+
+		if (bRecreateClothing)
+		{
+			if (USkeletalMeshComponent* SkelMeshComponent = Cast<USkeletalMeshComponent>(Component)) SkelMeshComponent->RecreateClothingActors();
+		}
+
+		Component->MarkRenderDynamicDataDirty();
+		Component->DoDeferredRenderUpdates_Concurrent();
+	}
+}
+
+// Other profiles using the shared bone asset, saved referencers are loaded, loaded profiles not saved yet are included
+static void GatherSharedBoneAnimUsers(UVertexAnimBoneAsset* SharedBoneAnim, const UVertexAnimProfile* Except, TArray <UVertexAnimProfile*>& OutUsers)
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+
+	TArray <FName> Referencers;
+	AssetRegistry.GetReferencers(SharedBoneAnim->GetOutermost()->GetFName(), Referencers);
+	for (const FName& PackageName : Referencers)
+	{
+		TArray <FAssetData> Assets;
+		AssetRegistry.GetAssetsByPackageName(PackageName, Assets);
+		for (const FAssetData& Asset : Assets)
+		{
+			if (Asset.GetClass() == UVertexAnimProfile::StaticClass()) Asset.GetAsset();
+		}
+	}
+
+	for (TObjectIterator<UVertexAnimProfile> It; It; ++It)
+	{
+		if ((*It != Except) && (It->SharedBoneAnim == SharedBoneAnim)) OutUsers.AddUnique(*It);
+	}
+}
+
+static bool HaveSameClips(const TArray <FVASequenceData>& A, const TArray <FVASequenceData>& B)
+{
+	if (A.Num() != B.Num()) return false;
+
+	for (int32 i = 0; i < A.Num(); i++)
+	{
+		if ((A[i].SequenceRef != B[i].SequenceRef) || (A[i].NumFrames != B[i].NumFrames)) return false;
+	}
+
+	return true;
+}
+
+// Bounds of bone anims taken from a shared bone asset, no pose is evaluated so the mesh is skinned with the decoded bone transforms
+static void CalcSharedBoneAnimBounds(UVertexAnimProfile* Profile, const TArray <USkinnedMeshComponent*>& Components)
+{
+	const FVATextureData& BonePos = Profile->BonePosData_CPU;
+	const FVATextureData& BoneRot = Profile->BoneRotData_CPU;
+
+	TArray <TArray <int32>> MeshToColumn;
+	MeshToColumn.SetNum(Components.Num());
+	for (int32 Part = 0; Part < Components.Num(); Part++)
+	{
+		MapMeshToBoneColumns(Components[Part]->SkeletalMesh->RefSkeleton, Profile, MeshToColumn[Part]);
+	}
+
+	TArray <FMatrix> RefToLocal;
+
+	for (int32 i = 0; i < Profile->Anims_Bone.Num(); i++)
+	{
+		FVASequenceData& Anim = Profile->Anims_Bone[i];
+		Anim.Bounds_Generated.Init();
+		Anim.FrameBounds_Generated.Reset(Anim.NumFrames);
+
+		for (int32 j = 0; j < Anim.NumFrames; j++)
+		{
+			const int32 RowStart = FVertexAnimDecoder::CalcRow_Bone(Profile, i, j) * BonePos.Width;
+			FBox FrameBounds(ForceInit);
+
+			for (int32 Part = 0; Part < Components.Num(); Part++)
+			{
+				// The bone textures hold the ref to local transforms, without scale. Bones without a column skin no vert
+				RefToLocal.SetNum(MeshToColumn[Part].Num());
+				for (int32 B = 0; B < RefToLocal.Num(); B++)
+				{
+					if (MeshToColumn[Part][B] == INDEX_NONE)
+					{
+						RefToLocal[B] = FMatrix::Identity;
+						continue;
+					}
+
+					const int32 Texel = RowStart + MeshToColumn[Part][B];
+					RefToLocal[B] = FTransform(
+						FVertexAnimDecoder::DecodeQuat(BoneRot.GetTexel(Texel)),
+						FVertexAnimDecoder::DecodeVectorHDR(BonePos.GetTexel(Texel), Profile->MaxValuePosition_Bone)).ToMatrixNoScale();
+				}
+
+				FSkeletalMeshLODRenderData& LODData = Components[Part]->MeshObject->GetSkeletalMeshRenderData().LODRenderData[0];
+				TArray <FVector> SkinnedPositions;
+				USkinnedMeshComponent::ComputeSkinnedPositions(
+					Components[Part], SkinnedPositions, RefToLocal, LODData, *LODData.GetSkinWeightVertexBuffer());
+
+				FrameBounds += FBox(SkinnedPositions);
+			}
+
+			Anim.FrameBounds_Generated.Add(FrameBounds);
+			Anim.Bounds_Generated += FrameBounds;
+		}
+	}
+}
+
+// Frame texels of the unique verts in cloth simulated sections of the skinned LOD 0, with their ref pose positions
+static void GatherClothTexels(
+	const TArray <USkinnedMeshComponent*>& Components, const TArray <TArray <int32>>& PartUniqueSourceIDs,
+	const TArray <TArray <FVector>>& PartRefPosePositions, const TArray <int32>& FirstUniques,
+	TArray <int32>& OutClothTexels, TArray <FVector>& OutClothRefPositions)
+{
+	for (int32 Part = 0; Part < Components.Num(); Part++)
+	{
+		const FSkeletalMeshLODRenderData& LODData = Components[Part]->MeshObject->GetSkeletalMeshRenderData().LODRenderData[0];
+
+		TArray <bool> IsClothVert;
+		IsClothVert.SetNumZeroed(LODData.GetNumVertices());
+		for (const FSkelMeshRenderSection& Section : LODData.RenderSections)
+		{
+			if (!Section.HasClothingData()) continue;
+
+			for (uint32 v = 0; v < Section.NumVertices; v++) IsClothVert[Section.BaseVertexIndex + v] = true;
+		}
+
+		for (int32 k = 0; k < PartUniqueSourceIDs[Part].Num(); k++)
+		{
+			if (!IsClothVert[PartUniqueSourceIDs[Part][k]]) continue;
+
+			OutClothTexels.Add(FirstUniques[Part] + k);
+			OutClothRefPositions.Add(PartRefPosePositions[Part][k]);
+		}
+	}
+}
+
+// Blends the cloth verts of the last frames of a clip towards its first frame so continuously simulated cloth loops without a pop,
+// skinned verts keep their pose. The frame bounds of the blended frames are grown to the blended cloth positions
+static void BlendClothLoopClosure(
+	TArray <FVector4>& GridVertPos, TArray <FVector4>& GridVertNormal, FVASequenceData& Anim,
+	const TArray <int32>& ClothTexels, const TArray <FVector>& ClothRefPositions,
+	const int32 FirstFrame, const int32 PerFrameArrayNum, const int32 NumBlendFrames, const bool bQTangent)
+{
+	const int32 NumFrames = Anim.FrameBounds_Generated.Num();
+	const int32 NumBlend = FMath::Min(NumBlendFrames, NumFrames - 1);
+	if ((NumBlend <= 0) || (ClothTexels.Num() == 0)) return;
+
+	for (int32 b = 0; b < NumBlend; b++)
+	{
+		const float Alpha = (b + 1) / (float)(NumBlend + 1);
+		const int32 Frame = NumFrames - NumBlend + b;
+		const int32 Dst = (FirstFrame + Frame) * PerFrameArrayNum;
+		const int32 Src = FirstFrame * PerFrameArrayNum;
+
+		for (int32 c = 0; c < ClothTexels.Num(); c++)
+		{
+			const int32 k = ClothTexels[c];
+			GridVertPos[Dst + k] = FMath::Lerp(GridVertPos[Dst + k], GridVertPos[Src + k], Alpha);
+			Anim.FrameBounds_Generated[Frame] += ClothRefPositions[c] + FVector(GridVertPos[Dst + k]);
+
+			if (bQTangent)
+			{
+				// The sign of W holds the bitangent sign, frames with another sign are not blended
+				const FVector4& From = GridVertNormal[Dst + k];
+				const FVector4& To = GridVertNormal[Src + k];
+				if ((From.W < 0.f) != (To.W < 0.f)) continue;
+
+				FQuat Q(FMath::Lerp(From.X, To.X, Alpha), FMath::Lerp(From.Y, To.Y, Alpha), FMath::Lerp(From.Z, To.Z, Alpha), FMath::Lerp(From.W, To.W, Alpha));
+				Q.Normalize();
+				GridVertNormal[Dst + k] = FVector4(Q.X, Q.Y, Q.Z, Q.W);
+				continue;
+			}
+
+			GridVertNormal[Dst + k] = FMath::Lerp(GridVertNormal[Dst + k], GridVertNormal[Src + k], Alpha);
+		}
+	}
+
+	Anim.Bounds_Generated.Init();
+	for (const FBox& FrameBounds : Anim.FrameBounds_Generated) Anim.Bounds_Generated += FrameBounds;
+}
+
+// Drives the preview component through every baked frame, one frame per GatherNextFrame so a bake can spread the gather
+// over editor ticks. Components are the parts baked together with the preview component being the first, bone anims are
+// skipped without bBakeBones. Begin and End switch the parts to CPU skinning and back, End puts them back into ref pose
+class FVATPoseGather
+{
+public:
+	FVATPoseGather(UVertexAnimProfile* InProfile, UDebugSkelMeshComponent* InPreviewComponent,
+		const TArray <USkinnedMeshComponent*>& InComponents, const TArray <int32>& InUniqueSourceIDs, const bool bInBakeBones)
+		: Profile(InProfile)
+		, PreviewComponent(InPreviewComponent)
+		, Components(InComponents)
+		, UniqueSourceIDs(InUniqueSourceIDs)
+		, bBakeBones(bInBakeBones && (InProfile->Anims_Bone.Num() > 0))
+	{
+		NumFrames = Profile->CalcTotalNumOfFrames_Vert() +
+			(bBakeBones ? Profile->CalcTotalNumOfFrames_Bone() + Profile->CalcTotalNumOfFrames_BoneLayers() : 0);
+	}
+
+	void Begin();
+	// False once every frame is gathered
+	bool GatherNextFrame();
+	void End();
+	// After End, once every frame is gathered
+	void Finish(TArray <FVector4>& OutGridVertPos, TArray <FVector4>& OutGridVertNormal, TArray <FVector4>& OutGridBonePos, TArray <FVector4>& OutGridBoneRot);
+
+	int32 GetNumFrames() const { return NumFrames; }
+	int32 GetNumFramesDone() const { return NumFramesDone; }
+
+private:
+	enum class EStage : uint8
+	{
+		VertAnims,
+		BoneAnims,
+		BoneLayers,
+		Done
+	};
+
+	void EvaluatePose(const float AnimTime);
+	void BeginClip(FVASequenceData& Anim);
+	void KeepClipPreviewed(const FVASequenceData& Anim);
+
+	void BeginVertClip();
+	void GatherVertFrame();
+	void EndVertClip();
+	float WrapAnimTime(const float Time) const;
+	void SimulateClothTo(const float TargetTime);
+
+	void BeginBoneAnims();
+	void BeginBoneClip();
+	void GatherBoneFrame();
+	void GatherBoneRows(FBox& OutFrameBounds, float& InOutMaxValue);
+
+	void BeginLayer();
+	void GatherLayerFrame();
+
+	UVertexAnimProfile* Profile;
+	UDebugSkelMeshComponent* PreviewComponent;
+	TArray <USkinnedMeshComponent*> Components;
+	TArray <int32> UniqueSourceIDs;
+	const bool bBakeBones;
+
+	TArray <bool> CachedCPUSkinning;
+
+	// The skinned buffers are only read in place, the ref pose is kept for the unique verts only.
+	// Each part writes its unique verts at its own offset inside a frame
+	TArray <int32> FirstUniques;
+	TArray <TArray <int32>> PartUniqueSourceIDs;
+	TArray <TArray <FVector>> PartRefPosePositions, PartRefPoseNormals;
+
+	int32 PerFrameArrayNum_Vert = 0;
+	int32 PerFrameArrayNum_Bone = 0;
+
+	// Frames are written into preallocated grids, texels past the unique verts of a frame stay zero
+	TArray <FVector4> GridVertPos;
+	TArray <FVector4> GridVertNormal;
+	int32 GridFrame_Vert = 0;
+	TArray <FVector4> GridBonePos;
+	TArray <FVector4> GridBoneRot;
+
+	float MaxValueOffset = 0.f;
+	float MaxValuePosBone = 0.f;
+
+	// YOW, need different sizes for vert and bone textures.
+	TArray <FVector4> ZeroedBonePos;
+	TArray <FVector4> ZeroedBoneRot;
+	TArray <FMatrix> RefToLocal;
+
+	TArray <int32> ClothTexels;
+	TArray <FVector> ClothRefPositions;
+	// Every part writes the columns of its bones (BoneNames_Generated of the layout), bones shared by parts hold the same transform
+	TArray <TArray <int32>> MeshToColumn;
+
+	// Current clip or layer and its next frame, INDEX_NONE before the clip started
+	EStage Stage = EStage::VertAnims;
+	int32 Clip = 0;
+	int32 Frame = INDEX_NONE;
+	float Length = 0.f;
+	float Step = 0.f;
+	float SimTime = 0.f;
+	int32 FirstGridFrame = 0;
+	int32 LayerFirstTexel = 0;
+
+	int32 NumFrames = 0;
+	int32 NumFramesDone = 0;
+};
+
+void FVATPoseGather::Begin()
+{
+	constexpr bool bRecreateRenderStateImmediately = true;
+	CachedCPUSkinning.SetNumZeroed(Components.Num());
+
+	// 1 switch to CPU skinning
+	{
+		const int32 InLODIndex = 0;
+		{
+			if (USkinnedMeshComponent* MasterPoseComponentPtr = PreviewComponent->MasterPoseComponent.Get())
+			{
+				MasterPoseComponentPtr->SetForcedLOD(InLODIndex + 1);
+				MasterPoseComponentPtr->UpdateLODStatus();
+				MasterPoseComponentPtr->RefreshBoneTransforms(nullptr);
+			}
+			else
+			{
+				PreviewComponent->SetForcedLOD(InLODIndex + 1);
+				PreviewComponent->UpdateLODStatus();
+				PreviewComponent->RefreshBoneTransforms(nullptr);
+			}
+
+			for (int32 Part = 1; Part < Components.Num(); Part++)
+			{
+				Components[Part]->SetForcedLOD(InLODIndex + 1);
+				Components[Part]->UpdateLODStatus();
+			}
+
+			// switch to CPU skinning
+			for (int32 Part = 0; Part < Components.Num(); Part++)
+			{
+				CachedCPUSkinning[Part] = Components[Part]->GetCPUSkinningEnabled();
+
+				Components[Part]->SetCPUSkinningEnabled(true, bRecreateRenderStateImmediately);
+
+				check(Components[Part]->MeshObject);
+				check(Components[Part]->MeshObject->IsCPUSkinned());
+			}
+		}
+	}
+
+	// 2 Make Sure it in ref pose
+	PreviewComponent->EnablePreview(true, NULL);
+	PreviewComponent->RefreshBoneTransforms(nullptr);
+	PreviewComponent->ClearMotionVector();
+	RefreshFollowerMeshes(Components, false);
+	FlushRenderingCommands();
+
+	TArray <int32> FirstVerts;
+	FirstVerts.Add(0);
+	for (USkinnedMeshComponent* Component : Components)
+	{
+		FirstVerts.Add(FirstVerts.Last() + GetCachedFinalVerts(Component).Num());
+	}
+
+	SplitUniqueVertsByPart(UniqueSourceIDs, FirstVerts, FirstUniques);
+
+	PartUniqueSourceIDs.SetNum(Components.Num());
+	PartRefPosePositions.SetNum(Components.Num());
+	PartRefPoseNormals.SetNum(Components.Num());
+
+	for (int32 Part = 0; Part < Components.Num(); Part++)
+	{
+		for (int32 u = FirstUniques[Part]; u < FirstUniques[Part + 1]; u++)
+		{
+			PartUniqueSourceIDs[Part].Add(UniqueSourceIDs[u] - FirstVerts[Part]);
+		}
+
+		GatherUniqueVerts(GetCachedFinalVerts(Components[Part]), PartUniqueSourceIDs[Part], PartRefPosePositions[Part], PartRefPoseNormals[Part]);
+	}
+
+	PerFrameArrayNum_Vert = Profile->OverrideSize_Vert.X * Profile->RowsPerFrame_Vert;
+	PerFrameArrayNum_Bone = Profile->OverrideSize_Bone.X;
+
+	GridVertPos.SetNumZeroed(Profile->Anims_Vert.Num() ? PerFrameArrayNum_Vert * Profile->CalcTotalNumOfFrames_Vert() : 0);
+	GridVertNormal.SetNumZeroed(GridVertPos.Num());
+
+	GridBonePos.Reserve(bBakeBones ? PerFrameArrayNum_Bone * (Profile->CalcTotalRequiredHeight_Bone() + 1) : 0);
+	GridBoneRot.Reserve(GridBonePos.Max());
+
+	ZeroedBonePos.SetNumZeroed(PerFrameArrayNum_Bone);
+	ZeroedBoneRot.SetNumZeroed(PerFrameArrayNum_Bone);
+
+	if (Profile->Anims_Vert.Num() && Profile->ContinuousCloth)
+	{
+		GatherClothTexels(Components, PartUniqueSourceIDs, PartRefPosePositions, FirstUniques, ClothTexels, ClothRefPositions);
+	}
+}
+
+// 3 Store Values
+bool FVATPoseGather::GatherNextFrame()
+{
+	while (Stage != EStage::Done)
+	{
+		switch (Stage)
+		{
+		case EStage::VertAnims:
+			if (Clip >= Profile->Anims_Vert.Num())
+			{
+				if (bBakeBones) BeginBoneAnims();
+				Stage = bBakeBones ? EStage::BoneAnims : EStage::Done;
+				Clip = 0;
+				break;
+			}
+			if (Frame == INDEX_NONE) BeginVertClip();
+			if (Frame < Profile->Anims_Vert[Clip].NumFrames)
+			{
+				// Continuous cloth keeps one simulation running through the clip, the editor ticks the preview scene
+				// between frames, so such a clip is gathered within one call
+				do
+				{
+					GatherVertFrame();
+				}
+				while (Profile->ContinuousCloth && (Frame < Profile->Anims_Vert[Clip].NumFrames));
+				return true;
+			}
+			EndVertClip();
+			Clip++;
+			Frame = INDEX_NONE;
+			break;
+
+		case EStage::BoneAnims:
+			if (Clip >= Profile->Anims_Bone.Num())
+			{
+				Stage = EStage::BoneLayers;
+				Clip = 0;
+				break;
+			}
+			if (Frame == INDEX_NONE) BeginBoneClip();
+			if (Frame < Profile->Anims_Bone[Clip].NumFrames)
+			{
+				GatherBoneFrame();
+				return true;
+			}
+			Clip++;
+			Frame = INDEX_NONE;
+			break;
+
+		case EStage::BoneLayers:
+			if (Clip >= Profile->Layers_Bone.Num())
+			{
+				Stage = EStage::Done;
+				break;
+			}
+			if (Frame == INDEX_NONE) BeginLayer();
+			if ((Frame < Profile->Layers_Bone[Clip].Anim.NumFrames) && (Profile->Layers_Bone[Clip].Columns_Generated.Num() > 0))
+			{
+				GatherLayerFrame();
+				return true;
+			}
+			Clip++;
+			Frame = INDEX_NONE;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	return false;
+}
+
+void FVATPoseGather::EvaluatePose(const float AnimTime)
+{
+	VAT_SCOPE(EvaluatePose);
+
+	PreviewComponent->SetPosition(AnimTime, false);
+	PreviewComponent->RefreshBoneTransforms(nullptr);
+	PreviewComponent->ClearMotionVector();
+	FlushRenderingCommands();
+}
+
+void FVATPoseGather::BeginClip(FVASequenceData& Anim)
+{
+	PreviewComponent->EnablePreview(true, Anim.SequenceRef);
+	UAnimSingleNodeInstance* SingleNodeInstance = PreviewComponent->GetSingleNodeInstance();
+
+	Length = SingleNodeInstance->GetLength();
+	Step = Length / Anim.NumFrames;
+
+	Anim.Speed_Generated = 1.f / Length;
+	Anim.FrameRows_Generated.Reset();
+	Anim.Bounds_Generated.Init();
+	Anim.FrameBounds_Generated.Reset(Anim.NumFrames);
+
+	Frame = 0;
+}
+
+// The preview asset can be changed in Persona between editor ticks, the clip being gathered is put back
+void FVATPoseGather::KeepClipPreviewed(const FVASequenceData& Anim)
+{
+	UAnimSingleNodeInstance* SingleNodeInstance = PreviewComponent->GetSingleNodeInstance();
+	if ((SingleNodeInstance == NULL) || (SingleNodeInstance->GetAnimationAsset() != Anim.SequenceRef))
+	{
+		PreviewComponent->EnablePreview(true, Anim.SequenceRef);
+	}
+}
+
+void FVATPoseGather::BeginVertClip()
+{
+	BeginClip(Profile->Anims_Vert[Clip]);
+	Profile->Anims_Vert[Clip].AnimStart_Generated = Profile->CalcStartHeightOfAnim_Vert(Clip);
+
+	// Continuous cloth keeps one simulation running through the clip, clip time wraps so the pre-roll plays its end
+	SimTime = -Profile->ClothPreRoll;
+	if (Profile->ContinuousCloth)
+	{
+		PreviewComponent->SetPosition(WrapAnimTime(SimTime), false);
+		PreviewComponent->RefreshBoneTransforms(nullptr);
+		PreviewComponent->RecreateClothingActors();
+		RefreshFollowerMeshes(Components, true);
+	}
+
+	FirstGridFrame = GridFrame_Vert;
+}
+
+float FVATPoseGather::WrapAnimTime(const float Time) const
+{
+	const float Wrapped = (Length > 0.f) ? FMath::Fmod(Time, Length) : 0.f;
+	return (Wrapped < 0.f) ? Wrapped + Length : Wrapped;
+}
+
+void FVATPoseGather::SimulateClothTo(const float TargetTime)
+{
+	const float SubstepTime = 1.f / FMath::Max(Profile->ClothSubstepRate, 1.f);
+	while (SimTime < TargetTime - KINDA_SMALL_NUMBER)
+	{
+		const float DeltaTime = FMath::Min(SubstepTime, TargetTime - SimTime);
+		SimTime = (DeltaTime < SubstepTime) ? TargetTime : SimTime + DeltaTime;
+
+		PreviewComponent->SetPosition(WrapAnimTime(SimTime), false);
+		PreviewComponent->RefreshBoneTransforms(nullptr);
+		RefreshFollowerMeshes(Components, false);
+		PreviewComponent->GetWorld()->Tick(ELevelTick::LEVELTICK_All, DeltaTime);
+	}
+}
+
+void FVATPoseGather::GatherVertFrame()
+{
+	FVASequenceData& Anim = Profile->Anims_Vert[Clip];
+	const float AnimTime = Step * Frame;
+	KeepClipPreviewed(Anim);
+
+	{
+		VAT_SCOPE(EvaluatePose);
+
+		if (Profile->ContinuousCloth)
+		{
+			SimulateClothTo(AnimTime);
+		}
+		else
+		{
+			PreviewComponent->SetPosition(AnimTime, false);
+			PreviewComponent->RefreshBoneTransforms(nullptr);
+			PreviewComponent->RecreateClothingActors();
+			RefreshFollowerMeshes(Components, true);
+			// Cloth Ticking
+			for (int32 P = 0; P < 8; P++) PreviewComponent->GetWorld()->Tick(ELevelTick::LEVELTICK_All, Step);
+		}
+
+		PreviewComponent->ClearMotionVector();
+
+		FlushRenderingCommands();
+	}
+
+	FBox FrameBounds(ForceInit);
+
+	for (int32 Part = 0; Part < Components.Num(); Part++)
+	{
+		const TArray <FFinalSkinVertex>& FinalVerts = GetCachedFinalVerts(Components[Part]);
+
+		const int32 FrameStart = (GridFrame_Vert * PerFrameArrayNum_Vert) + FirstUniques[Part];
+		const int32 NumPartUniques = PartUniqueSourceIDs[Part].Num();
+		StoreFrameVertDeltas(FinalVerts, PartRefPosePositions[Part], PartRefPoseNormals[Part], PartUniqueSourceIDs[Part],
+			TArrayView <FVector4>(GridVertPos.GetData() + FrameStart, NumPartUniques),
+			TArrayView <FVector4>(GridVertNormal.GetData() + FrameStart, NumPartUniques),
+			MaxValueOffset, Profile->NormalEncoding == EVANormalEncoding::QTangent);
+
+		FrameBounds += CalcSkinVertsBounds(FinalVerts);
+	}
+	GridFrame_Vert++;
+
+	Anim.FrameBounds_Generated.Add(FrameBounds);
+	Anim.Bounds_Generated += FrameBounds;
+
+	Frame++;
+	NumFramesDone++;
+}
+
+void FVATPoseGather::EndVertClip()
+{
+	if (Profile->ContinuousCloth)
+	{
+		BlendClothLoopClosure(GridVertPos, GridVertNormal, Profile->Anims_Vert[Clip], ClothTexels, ClothRefPositions, FirstGridFrame,
+			PerFrameArrayNum_Vert, Profile->ClothLoopBlendFrames, Profile->NormalEncoding == EVANormalEncoding::QTangent);
+	}
+}
+
+// Ref Pose in Row 0
+void FVATPoseGather::BeginBoneAnims()
+{
+	MeshToColumn.SetNum(Components.Num());
+	for (int32 Part = 0; Part < Components.Num(); Part++)
+	{
+		MapMeshToBoneColumns(Components[Part]->SkeletalMesh->RefSkeleton, Profile, MeshToColumn[Part]);
+	}
+
+	PreviewComponent->EnablePreview(true, NULL);
+	PreviewComponent->RefreshBoneTransforms(nullptr);
+	PreviewComponent->ClearMotionVector();
+	FlushRenderingCommands();
+
+	for (int32 Part = 0; Part < Components.Num(); Part++)
+	{
+		const auto& RefSkeleton = Components[Part]->SkeletalMesh->RefSkeleton;
+
+		for (int32 B = 0; B < RefSkeleton.GetNum(); B++)
+		{
+			const int32 GlobalID = MeshToColumn[Part][B];
+			if (GlobalID == INDEX_NONE) continue;
+
+			FTransform RefTM = FAnimationRuntime::GetComponentSpaceTransformRefPose(RefSkeleton, B);
+			FQuat RefQuat = RefTM.GetRotation();
+			QuatSave(RefQuat);
+			ZeroedBonePos[GlobalID] = RefTM.GetLocation();
+			ZeroedBoneRot[GlobalID] = FVector4(RefQuat.X, RefQuat.Y, RefQuat.Z, RefQuat.W);
+		}
+	}
+	GridBonePos.Append(ZeroedBonePos);
+	GridBoneRot.Append(ZeroedBoneRot);
+}
+
+// Full rows of the evaluated pose into ZeroedBonePos / ZeroedBoneRot
+void FVATPoseGather::GatherBoneRows(FBox& OutFrameBounds, float& InOutMaxValue)
+{
+	for (int32 Part = 0; Part < Components.Num(); Part++)
+	{
+		// Followers read the bone transforms of the preview component through their master bone map
+		Components[Part]->CacheRefToLocalMatrices(RefToLocal);
+
+		StoreFrameBoneTransforms(RefToLocal, MeshToColumn[Part], ZeroedBonePos, ZeroedBoneRot, InOutMaxValue);
+
+		// Bone anims are not CPU skinned per frame, skin the positions with the cached matrices for the bounds
+		FSkeletalMeshLODRenderData& LODData = Components[Part]->MeshObject->GetSkeletalMeshRenderData().LODRenderData[0];
+		TArray <FVector> SkinnedPositions;
+		USkinnedMeshComponent::ComputeSkinnedPositions(
+			Components[Part], SkinnedPositions, RefToLocal, LODData, *LODData.GetSkinWeightVertexBuffer());
+
+		OutFrameBounds += FBox(SkinnedPositions);
+	}
+}
+
+void FVATPoseGather::BeginBoneClip()
+{
+	BeginClip(Profile->Anims_Bone[Clip]);
+	Profile->Anims_Bone[Clip].AnimStart_Generated = Profile->CalcStartHeightOfAnim_Bone(Clip);
+}
+
+void FVATPoseGather::GatherBoneFrame()
+{
+	FVASequenceData& Anim = Profile->Anims_Bone[Clip];
+
+	KeepClipPreviewed(Anim);
+	EvaluatePose(Step * Frame);
+
+	FBox FrameBounds(ForceInit);
+	GatherBoneRows(FrameBounds, MaxValuePosBone);
+
+	Anim.FrameBounds_Generated.Add(FrameBounds);
+	Anim.Bounds_Generated += FrameBounds;
+
+	GridBonePos.Append(ZeroedBonePos);
+	GridBoneRot.Append(ZeroedBoneRot);
+
+	Frame++;
+	NumFramesDone++;
+}
+
+// Bone layers, the layer columns of each frame packed side by side into the rows after the anims
+void FVATPoseGather::BeginLayer()
+{
+	FVABoneLayerData& Layer = Profile->Layers_Bone[Clip];
+
+	BeginClip(Layer.Anim);
+	Layer.Anim.AnimStart_Generated = Profile->CalcStartHeightOfLayer_Bone(Clip);
+
+	LayerFirstTexel = GridBonePos.Num();
+	GridBonePos.AddZeroed(Layer.CalcNumRows() * PerFrameArrayNum_Bone);
+	GridBoneRot.AddZeroed(Layer.CalcNumRows() * PerFrameArrayNum_Bone);
+
+	// A layer without columns stores nothing, its frames are not evaluated
+	if (Layer.Columns_Generated.Num() == 0) NumFramesDone += Layer.Anim.NumFrames;
+}
+
+void FVATPoseGather::GatherLayerFrame()
+{
+	FVABoneLayerData& Layer = Profile->Layers_Bone[Clip];
+	const int32 NumLayerColumns = Layer.Columns_Generated.Num();
+
+	KeepClipPreviewed(Layer.Anim);
+	EvaluatePose(Step * Frame);
+
+	// Full rows of the layer pose, only the layer columns are kept
+	FBox FrameBounds(ForceInit);
+	float UnusedMaxValue = 0.f;
+	GatherBoneRows(FrameBounds, UnusedMaxValue);
+
+	Layer.Anim.FrameBounds_Generated.Add(FrameBounds);
+	Layer.Anim.Bounds_Generated += FrameBounds;
+
+	auto ColumnTransform = [this](const int32 Column)
+	{
+		const FVector4& Rot = ZeroedBoneRot[Column];
+		return FTransform(FQuat(Rot.X, Rot.Y, Rot.Z, Rot.W), FVector(ZeroedBonePos[Column]));
+	};
+
+	const int32 FrameTexel = LayerFirstTexel + ((Frame / Layer.FramesPerRow_Generated) * PerFrameArrayNum_Bone) +
+		((Frame % Layer.FramesPerRow_Generated) * NumLayerColumns);
+	for (int32 k = 0; k < NumLayerColumns; k++)
+	{
+		FTransform LayerTransform = ColumnTransform(Layer.Columns_Generated[k]);
+
+		// Override layers are stored relative to their attach bone, the base anim supplies it at runtime
+		const int32 AttachColumn = Layer.AttachColumns_Generated[k];
+		if ((Layer.Blend == EVALayerBlend::Override) && (AttachColumn != INDEX_NONE))
+		{
+			LayerTransform = LayerTransform.GetRelativeTransform(ColumnTransform(AttachColumn));
+		}
+
+		FQuat Q = LayerTransform.GetRotation();
+		QuatSave(Q);
+		const FVector Pos = LayerTransform.GetTranslation();
+		MaxValuePosBone = FMath::Max(MaxValuePosBone, Pos.GetAbsMax());
+
+		GridBonePos[FrameTexel + k] = Pos;
+		GridBoneRot[FrameTexel + k] = FVector4(Q.X, Q.Y, Q.Z, Q.W);
+	}
+
+	Frame++;
+	NumFramesDone++;
+}
+
+// 4 Put Mesh back into ref pose
+void FVATPoseGather::End()
+{
+	constexpr bool bRecreateRenderStateImmediately = true;
+
+	PreviewComponent->EnablePreview(true, NULL);
+	PreviewComponent->RefreshBoneTransforms(nullptr);
+
+	PreviewComponent->ClearMotionVector();
+
+	// switch back to non CPU skinning
+	for (int32 Part = 0; Part < CachedCPUSkinning.Num(); Part++)
+	{
+		// switch skinning mode, LOD etc. back
+		Components[Part]->SetForcedLOD(0);
+		Components[Part]->SetCPUSkinningEnabled(CachedCPUSkinning[Part], bRecreateRenderStateImmediately);
+	}
+
+	FlushRenderingCommands();
+}
+
+void FVATPoseGather::Finish(
+	TArray <FVector4>& OutGridVertPos, TArray <FVector4>& OutGridVertNormal, TArray <FVector4>& OutGridBonePos, TArray <FVector4>& OutGridBoneRot)
+{
+	// Octahedral normals are absolute, the ref pose normal of each unique vert is added back to its deltas
+	if ((Profile->NormalEncoding == EVANormalEncoding::Octahedral) || (Profile->NormalEncoding == EVANormalEncoding::OctahedralInOffsets))
+	{
+		for (int32 F = 0; F < GridFrame_Vert; F++)
+		{
+			for (int32 Part = 0; Part < Components.Num(); Part++)
+			{
+				const int32 FrameStart = (F * PerFrameArrayNum_Vert) + FirstUniques[Part];
+				for (int32 k = 0; k < PartRefPoseNormals[Part].Num(); k++)
+				{
+					GridVertNormal[FrameStart + k] += FVector4(PartRefPoseNormals[Part][k], 0.f);
+				}
+			}
+		}
+	}
+
+	Profile->MaxValueOffset_Vert = MaxValueOffset;
+	Profile->MaxValuePosition_Bone = MaxValuePosBone;
+
+	Profile->MarkPackageDirty();
+
+	OutGridVertPos = MoveTemp(GridVertPos);
+	OutGridVertNormal = MoveTemp(GridVertNormal);
+	OutGridBonePos = MoveTemp(GridBonePos);
+	OutGridBoneRot = MoveTemp(GridBoneRot);
+}
+
+
+// Sparse vert anims: unique verts that never move more than the threshold all read texel 0, which stays zero, and the moving
+// ones are packed after it. Rebuilds the gathered frames for the new layout, OutTexelRemap gives the new texel of every unique vert
+static void CompactStaticVerts(UVertexAnimProfile* Profile, const int32 NumUniqueVerts,
+	TArray <FVector4>& GridVertPos, TArray <FVector4>& GridVertNormal, TArray <int32>& OutTexelRemap)
+{
+	VAT_SCOPE(CompactStaticVerts);
+
+	// Normal deltas this small do not show in the shading
+	const float NormalThreshold = 1.f / 255.f;
+
+	const int32 NumFrames = Profile->CalcTotalNumOfFrames_Vert();
+	const int32 OldPerFrame = Profile->OverrideSize_Vert.X * Profile->RowsPerFrame_Vert;
+	check(GridVertPos.Num() == OldPerFrame * NumFrames);
+
+	TArray <bool> Moving;
+	Moving.SetNumZeroed(NumUniqueVerts);
+
+	for (int32 F = 0; F < NumFrames; F++)
+	{
+		for (int32 k = 0; k < NumUniqueVerts; k++)
+		{
+			const int32 Src = (F * OldPerFrame) + k;
+			Moving[k] = Moving[k] ||
+				(FVector(GridVertPos[Src]).GetAbsMax() > Profile->SparseThreshold) ||
+				(FVector(GridVertNormal[Src]).GetAbsMax() > NormalThreshold);
+		}
+	}
+
+	OutTexelRemap.SetNumUninitialized(NumUniqueVerts);
+	int32 NumTexels = 1;
+	for (int32 k = 0; k < NumUniqueVerts; k++)
+	{
+		OutTexelRemap[k] = Moving[k] ? NumTexels++ : 0;
+	}
+
+	FIntPoint TextureSize;
+	Profile->CalcLayout_Vert(NumTexels, Profile->RowsPerFrame_Vert, TextureSize);
+	Profile->OverrideSize_Vert = TextureSize;
+	const int32 NewPerFrame = Profile->OverrideSize_Vert.X * Profile->RowsPerFrame_Vert;
+
+	TArray <FVector4> NewVertPos, NewVertNormal;
+	NewVertPos.SetNumZeroed(NewPerFrame * NumFrames);
+	NewVertNormal.SetNumZeroed(NewVertPos.Num());
+
+	for (int32 F = 0; F < NumFrames; F++)
+	{
+		for (int32 k = 0; k < NumUniqueVerts; k++)
+		{
+			if (OutTexelRemap[k] == 0) continue;
+
+			NewVertPos[(F * NewPerFrame) + OutTexelRemap[k]] = GridVertPos[(F * OldPerFrame) + k];
+			NewVertNormal[(F * NewPerFrame) + OutTexelRemap[k]] = GridVertNormal[(F * OldPerFrame) + k];
+		}
+	}
+
+	GridVertPos = MoveTemp(NewVertPos);
+	GridVertNormal = MoveTemp(NewVertNormal);
+
+	// Fewer rows per frame, the anims start on other rows
+	for (int32 i = 0; i < Profile->Anims_Vert.Num(); i++)
+	{
+		Profile->Anims_Vert[i].AnimStart_Generated = Profile->CalcStartHeightOfAnim_Vert(i);
+	}
+}
+
+// Frames whose texels all match an earlier frame within the tolerances (A for GridA, B for GridB) are stored once.
+// Compacts the gathered frames of PerFrame texels in place, OutFrameMap gives the stored frame of every gathered frame
+static int32 DeduplicateGridFrames(TArray <FVector4>& GridA, TArray <FVector4>& GridB, const int32 PerFrame,
+	const float ToleranceA, const float ToleranceB, TArray <int32>& OutFrameMap)
+{
+	VAT_SCOPE(DeduplicateFrames);
+
+	const int32 NumFrames = PerFrame ? GridA.Num() / PerFrame : 0;
+	check(GridB.Num() == GridA.Num());
+
+	auto IsNear = [](const FVector4& A, const FVector4& B, const float Tolerance)
+	{
+		return (FMath::Abs(A.X - B.X) <= Tolerance) && (FMath::Abs(A.Y - B.Y) <= Tolerance) &&
+			(FMath::Abs(A.Z - B.Z) <= Tolerance) && (FMath::Abs(A.W - B.W) <= Tolerance);
+	};
+
+	auto FramesMatch = [&](const int32 Frame, const int32 Stored)
+	{
+		const int32 Src = Frame * PerFrame;
+		const int32 Dst = Stored * PerFrame;
+		for (int32 k = 0; k < PerFrame; k++)
+		{
+			if (!IsNear(GridA[Src + k], GridA[Dst + k], ToleranceA) || !IsNear(GridB[Src + k], GridB[Dst + k], ToleranceB)) return false;
+		}
+		return true;
+	};
+
+	OutFrameMap.SetNumUninitialized(NumFrames);
+	int32 NumStored = 0;
+
+	for (int32 F = 0; F < NumFrames; F++)
+	{
+		// Latest stored frame first, holds repeat the frame before them
+		int32 Match = INDEX_NONE;
+		for (int32 Stored = NumStored - 1; (Stored >= 0) && (Match == INDEX_NONE); Stored--)
+		{
+			if (FramesMatch(F, Stored)) Match = Stored;
+		}
+
+		if (Match != INDEX_NONE)
+		{
+			OutFrameMap[F] = Match;
+			continue;
+		}
+
+		// Stored frames are packed in front of the ones still to test
+		if (NumStored != F)
+		{
+			FMemory::Memcpy(&GridA[NumStored * PerFrame], &GridA[F * PerFrame], PerFrame * sizeof(FVector4));
+			FMemory::Memcpy(&GridB[NumStored * PerFrame], &GridB[F * PerFrame], PerFrame * sizeof(FVector4));
+		}
+		OutFrameMap[F] = NumStored++;
+	}
+
+	GridA.SetNum(NumStored * PerFrame);
+	GridB.SetNum(NumStored * PerFrame);
+
+	return NumStored;
+}
+
+// Fills the frame row tables of the clips, their frames follow each other in FrameMap from FirstFrame on
+static void AssignFrameRows(TArray <FVASequenceData>& Anims, const TArray <int32>& FrameMap, const int32 FirstFrame, const int32 RowsPerFrame)
+{
+	int32 Frame = FirstFrame;
+	for (FVASequenceData& Anim : Anims)
+	{
+		Anim.FrameRows_Generated.SetNumUninitialized(Anim.NumFrames);
+		for (int32 j = 0; j < Anim.NumFrames; j++)
+		{
+			Anim.FrameRows_Generated[j] = FrameMap[Frame++] * RowsPerFrame;
+		}
+	}
+}
+
+// Texture row of every row of the contiguous layout (AnimStart_Generated + Frame * RowsPerFrame + Row), the rows before
+// the first clip (the ref pose of the bone textures) keep theirs. One texel per row, Index % Width and Index / Width
+static void BuildFrameRowTable(const TArray <FVASequenceData>& Anims, const int32 FirstRow, const int32 RowsPerFrame,
+	TArray <uint16>& OutData, FIntPoint& OutSize)
+{
+	int32 NumRows = FirstRow;
+	for (const FVASequenceData& Anim : Anims)
+	{
+		NumRows += Anim.NumFrames * RowsPerFrame;
+	}
+
+	OutSize.X = FMath::Min((int32)FMath::RoundUpToPowerOfTwo(FMath::Max(NumRows, 1)), 4096);
+	OutSize.Y = FMath::DivideAndRoundUp(FMath::Max(NumRows, 1), OutSize.X);
+
+	OutData.Reset();
+	OutData.SetNumZeroed(OutSize.X * OutSize.Y);
+
+	for (int32 Row = 0; Row < FirstRow; Row++)
+	{
+		OutData[Row] = Row;
+	}
+
+	for (const FVASequenceData& Anim : Anims)
+	{
+		for (int32 j = 0; j < Anim.FrameRows_Generated.Num(); j++)
+		{
+			for (int32 r = 0; r < RowsPerFrame; r++)
+			{
+				OutData[Anim.AnimStart_Generated + (j * RowsPerFrame) + r] = (uint16)(Anim.FrameRows_Generated[j] + r);
+			}
+		}
+	}
+}
+
+// Points the vert anim UVs made for the OldSize layout to the compacted texels
+static void RemapVertAnimUVs(const UVertexAnimProfile* Profile, const FIntPoint& OldSize, const TArray <int32>& TexelRemap,
+	TArray <TArray <FVector2D>>& UVs_VertAnim)
+{
+	for (TArray <FVector2D>& LODUVs : UVs_VertAnim)
+	{
+		for (FVector2D& UV : LODUVs)
+		{
+			// Bone only verts of hybrid bakes
+			if (UV.X < 0.f) continue;
+
+			const int32 OldIndex = Profile->VertexIdAddressing ?
+				FVertexAnimDecoder::UnpackIndex(UV.X) : FVertexAnimDecoder::GridUVToVertexIndex(UV, OldSize);
+			UV = VertexIndexToUV(Profile, TexelRemap[OldIndex]);
+		}
+	}
+}
+
+static void EncodeData_Vec(const TArray <FVector4>& VectorData, const float MaxValue, const bool HDR, TArray <FFloat16Color>& Data)
+{
+	VAT_SCOPE(EncodeData_Vec);
+
+	// Texels are independent, chunks are encoded on worker threads
+	const int32 ChunkSize = 4096;
+	ParallelFor(FMath::DivideAndRoundUp(VectorData.Num(), ChunkSize), [&](int32 Chunk)
+	{
+		const int32 End = FMath::Min((Chunk + 1) * ChunkSize, VectorData.Num());
+		for (int32 i = Chunk * ChunkSize; i < End; i++)
+		{
+			FVector VectorValue = VectorData[i];
+			const float MaxDim = VectorValue.GetAbsMax();
+
+			if (MaxDim > 0.f)
+			{
+				float Mag;
+				if (HDR)
+				{
+					VectorValue.X = VectorValue.X / MaxDim;
+					VectorValue.Y = VectorValue.Y / MaxDim;
+					VectorValue.Z = VectorValue.Z / MaxDim;
+					Mag = -1.0 + ((MaxDim / MaxValue) * 2.0);
+
+					Data[i] = FLinearColor(VectorValue.X, VectorValue.Y, VectorValue.Z, Mag);
+				}
+				else
+				{
+					VectorValue.X = FVertexAnimUtils::EncodeFloat(VectorValue.X, MaxDim);
+					VectorValue.Y = FVertexAnimUtils::EncodeFloat(VectorValue.Y, MaxDim);
+					VectorValue.Z = FVertexAnimUtils::EncodeFloat(VectorValue.Z, MaxDim);
+					Mag = MaxDim / MaxValue;
+
+					Data[i] = FLinearColor(VectorValue.X, VectorValue.Y, VectorValue.Z, Mag);
+				}
+			}
+		}
+	});
+}
+
+// Absolute normals as octahedral 8:8 in one 16 bit channel, X in the high byte
+static void EncodeData_Octahedral16(const TArray <FVector4>& NormalData, TArray <uint16>& Data)
+{
+	VAT_SCOPE(EncodeData_Octahedral);
+
+	const int32 ChunkSize = 4096;
+	ParallelFor(FMath::DivideAndRoundUp(NormalData.Num(), ChunkSize), [&](int32 Chunk)
+	{
+		const int32 End = FMath::Min((Chunk + 1) * ChunkSize, NormalData.Num());
+		for (int32 i = Chunk * ChunkSize; i < End; i++)
+		{
+			Data[i] = (uint16)FVertexAnimDecoder::QuantizeOctahedral(FVector(NormalData[i]), FVertexAnimDecoder::OctahedralBits_Texture);
+		}
+	});
+}
+
+// Offsets relative to MaxValue in RGB and the octahedral 7:7 absolute normal in A, packed the same way as vertex ids
+static void EncodeData_OffsetsOctahedral(
+	const TArray <FVector4>& OffsetData, const TArray <FVector4>& NormalData, const float MaxValue, TArray <FFloat16Color>& Data)
+{
+	VAT_SCOPE(EncodeData_Octahedral);
+
+	const float InvMaxValue = (MaxValue > 0.f) ? 1.f / MaxValue : 0.f;
+
+	const int32 ChunkSize = 4096;
+	ParallelFor(FMath::DivideAndRoundUp(OffsetData.Num(), ChunkSize), [&](int32 Chunk)
+	{
+		const int32 End = FMath::Min((Chunk + 1) * ChunkSize, OffsetData.Num());
+		for (int32 i = Chunk * ChunkSize; i < End; i++)
+		{
+			const FVector Offset = FVector(OffsetData[i]) * InvMaxValue;
+			const uint32 Normal = FVertexAnimDecoder::QuantizeOctahedral(FVector(NormalData[i]), FVertexAnimDecoder::OctahedralBits_Offsets);
+
+			Data[i] = FLinearColor(Offset.X, Offset.Y, Offset.Z, FVertexAnimDecoder::PackIndex(Normal));
+		}
+	});
+}
+
+// QTangents are stored as they are, the sign of W is needed
+static void EncodeData_QTangent(const TArray <FVector4>& VectorData, TArray <FFloat16Color>& Data)
+{
+	VAT_SCOPE(EncodeData_Quat);
+
+	const int32 ChunkSize = 4096;
+	ParallelFor(FMath::DivideAndRoundUp(VectorData.Num(), ChunkSize), [&](int32 Chunk)
+	{
+		const int32 End = FMath::Min((Chunk + 1) * ChunkSize, VectorData.Num());
+		for (int32 i = Chunk * ChunkSize; i < End; i++)
+		{
+			Data[i] = FLinearColor(VectorData[i].X, VectorData[i].Y, VectorData[i].Z, VectorData[i].W);
+		}
+	});
+}
+
+static void EncodeData_Quat(const bool HD, const TArray <FVector4>& VectorData, TArray <FFloat16Color>& Data)
+{
+	VAT_SCOPE(EncodeData_Quat);
+
+	const int32 ChunkSize = 4096;
+	ParallelFor(FMath::DivideAndRoundUp(VectorData.Num(), ChunkSize), [&](int32 Chunk)
+	{
+		const int32 End = FMath::Min((Chunk + 1) * ChunkSize, VectorData.Num());
+		for (int32 i = Chunk * ChunkSize; i < End; i++)
+		{
+			FVector4 VectorValue = VectorData[i];
+			uint8 BigComp = 0;
+			float Max = -100.0;
+			FVector WinnerValue;
+
+			bool Bit0 = false;
+			bool Bit1 = false;
+
+			if (FMath::Abs(VectorValue[0]) > Max)
+			{
+				BigComp = 0;
+				Bit0 = 0, Bit1 = 0;
+				Max = FMath::Abs(VectorValue[0]);
+				WinnerValue = FVector(VectorValue[1], VectorValue[2], VectorValue[3]);
+			}
+			if (FMath::Abs(VectorValue[1]) > Max)
+			{
+				BigComp = 1;
+				Bit0 = 0, Bit1 = 1;
+				Max = FMath::Abs(VectorValue[1]);
+				WinnerValue = FVector(VectorValue[0], VectorValue[2], VectorValue[3]);
+			}
+			if (FMath::Abs(VectorValue[2]) > Max)
+			{
+				BigComp = 2;
+				Bit0 = 1, Bit1 = 0;
+				Max = FMath::Abs(VectorValue[2]);
+				WinnerValue = FVector(VectorValue[0], VectorValue[1], VectorValue[3]);
+			}
+			if (FMath::Abs(VectorValue[3]) > Max)
+			{
+				BigComp = 3;
+				Bit0 = 1, Bit1 = 1;
+				Max = FMath::Abs(VectorValue[3]);
+				WinnerValue = FVector(VectorValue[0], VectorValue[1], VectorValue[2]);
+			}
+
+			if (VectorValue[BigComp] < 0)
+			{
+				WinnerValue *= -1.0;
+			}
+
+			const float MaxDim = WinnerValue.GetAbsMax();
+			// for now no bit based encoding, just have quats be always HDR (double precission).
+			if (false)
+			{
+				/*
+				if (MaxDim > 0.f)
+				{
+					FVector4 Encoded = FVertexAnimUtils::BitEncodeVecId_HD(WinnerValue, 1.0, BigComp);
+					if(HD)
+						Data[i] = FLinearColor(Encoded);
+					else 
+						Data[i] = FLinearColor(FVertexAnimUtils::BitEncodeVecId(WinnerValue, 1.0, BigComp));
+
+					UE_LOG(LogUnrealMath, Warning, TEXT("Vec Value %s || Id %i || Result Encode %s"), 
+						*WinnerValue.ToString(), BigComp, *Encoded.ToString());
+				}
+				else
+				{
+					Data[i] = FLinearColor(0, 0, 0, 1);
+				}*/
+			}
+			else
+			{
+				if (MaxDim > 0.f) 
+				{
+			
+					float R = FMath::Max(0.001f, FVertexAnimUtils::EncodeFloat(WinnerValue.X, MaxDim)) * (Bit0 ? 1.0 : -1.0);
+					//R = FVertexAnimUtils::EncodeFloat(R * (Bit0 ? 1.0 : -1.0), 1.0);
+
+					float G = FMath::Max(0.001f, FVertexAnimUtils::EncodeFloat(WinnerValue.Y, MaxDim)) * (Bit1 ? 1.0 : -1.0);
+					//G = FVertexAnimUtils::EncodeFloat(G * (Bit1 ? 1.0 : -1.0), 1.0);
+
+					float B = WinnerValue.Z / MaxDim;// FVertexAnimUtils::EncodeFloat(WinnerValue.Z, MaxDim);
+
+					float A = -1.0 + ((MaxDim / 1.0) * 2.0);// 
+
+					Data[i] = FLinearColor(R, G, B, A);
+				}
+				else
+				{
+					Data[i] = FLinearColor(0, 0, 0, 1);
+				}
+			}
+		}
+	});
+}
+
+static UTexture2D* SetTextureSource(
+	UWorld* World, const FString PackagePath, const FString Name, 
+	UTexture2D* Texture, 
+	const int32 InSizeX, const int32 InSizeY,
+	const void* Data, const ETextureSourceFormat Format,
+	EObjectFlags InObjectFlags)
+{
+	VAT_SCOPE(SetTexture2);
+
+	UTexture2D* NewTexture;
+
+	{
+		
+		if (Texture != NULL)
+		{
+			NewTexture = NewObject<UTexture2D>(Texture->GetOuter(), FName(*Texture->GetName()), InObjectFlags);
+			
+		}
+		else
+		{
+			UPackage* Package = CreatePackage(NULL, *(PackagePath + Name));
+			check(Package);
+			Package->FullyLoad();
+
+			NewTexture = NewObject<UTexture2D>(Package, *Name, InObjectFlags);
+
+			FAssetRegistryModule::AssetCreated(NewTexture);
+		}
+
+		checkf(NewTexture, TEXT("%s"), *Name);
+
+		NewTexture->Source.Init(InSizeX, InSizeY, /*NumSlices=*/ 1, /*NumMips=*/ 1, Format);
+		uint32* TextureData = (uint32*)NewTexture->Source.LockMip(0);
+		const int32 TextureDataSize = NewTexture->Source.CalcMipSize(0);
+		
+		FMemory::Memcpy(TextureData, Data, TextureDataSize); // this did not blow up 
+		
+		NewTexture->Source.UnlockMip(0);
+
+		NewTexture->PostEditChange();
+
+		NewTexture->MarkPackageDirty();
+	}
+
+	return NewTexture;
+}
+
+static UTexture2D* SetTexture2(
+	UWorld* World, const FString PackagePath, const FString Name, 
+	UTexture2D* Texture, 
+	const int32 InSizeX, const int32 InSizeY,
+	const TArray <FFloat16Color>& Data,
+	EObjectFlags InObjectFlags)
+{
+	return SetTextureSource(World, PackagePath, Name, Texture, InSizeX, InSizeY, Data.GetData(), TSF_RGBA16F, InObjectFlags);
+}
+
+// Bone textures are read texel exact and never streamed
+static void SetBoneTextureSettings(UTexture2D* Texture)
+{
+	Texture->Filter = TextureFilter::TF_Nearest;
+	Texture->NeverStream = true;
+	Texture->CompressionSettings = TextureCompressionSettings::TC_HDR;
+	Texture->SRGB = false;
+
+	Texture->Modify();
+	Texture->MarkPackageDirty();
+	Texture->PostEditChange();
+	Texture->UpdateResource();
+}
+
+// 16 bit single channel textures (index tables, octahedral normals) are read texel exact. Grayscale keeps a G16 source
+// as G16, the built pixel format is checked since a G8 build would drop the low byte of every index
+static void SetG16TextureSettings(UTexture2D* Texture)
+{
+	Texture->Filter = TextureFilter::TF_Nearest;
+	Texture->NeverStream = true;
+	Texture->CompressionSettings = TextureCompressionSettings::TC_Grayscale;
+	Texture->SRGB = false;
+
+	Texture->Modify();
+	Texture->MarkPackageDirty();
+	Texture->PostEditChange();
+	Texture->UpdateResource();
+
+	if ((Texture->Source.GetFormat() != TSF_G16) || (Texture->GetPixelFormat() != PF_G16))
+	{
+		NotifyBakeWarning(FText::Format(LOCTEXT("TextureNotG16", "{0} does not build as 16 bit (G16), the values it holds lose their low byte"),
+			FText::FromString(Texture->GetName())));
+	}
+}
+
+// Index tables (frame rows, mirror columns) are 16 bit single channel
+static UTexture2D* SetIndexTableTexture(UWorld* World, const FString& PackagePath, const FString& Name, UTexture2D* Texture,
+	const FIntPoint& Size, const TArray <uint16>& Data, const EObjectFlags Flags)
+{
+	UTexture2D* Out = SetTextureSource(World, PackagePath, Name, Texture, Size.X, Size.Y, Data.GetData(), TSF_G16, Flags);
+	SetG16TextureSettings(Out);
+
+	return Out;
+}
+
+// Bit casts, the old value casts lost the packed bits
+float FVATEditorUtils::PackBits(const uint32& bit)
+{
+	return FVertexAnimDecoder::PackIndex(bit);
+}
+
+int FVATEditorUtils::UnPackBits(const float N)
+{
+	return FVertexAnimDecoder::UnpackIndex(N);
+}
+
+// A bake started from the Persona toolbar. Start checks and lays out the bake, the pose gather then runs one frame per editor tick
+// on the game thread, encoding runs on the thread pool and the static mesh and textures are written on the game thread once it
+// is done. Until then cancelling restores the profile and leaves existing assets untouched
+class FVATBake : public FGCObject, public TSharedFromThis<FVATBake>
+{
+public:
+	FVATBake(UDebugSkelMeshComponent* InPreviewComponent, UVertexAnimProfile* InProfile, const bool bInOnlyCreateStaticMesh, const FString& InPackageName);
+	virtual ~FVATBake();
+
+	// False when the bake does not start, the profile is restored and the reason shown then
+	bool Start();
+	// Ticker callback, false once the bake ended
+	bool Tick(float DeltaTime);
+	// Ends a bake that did not commit yet, waits for the encoding
+	void Cancel(const FText& Reason);
+
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override { return TEXT("FVATBake"); }
+
+private:
+	enum class EState : uint8
+	{
+		Gather,
+		Encode,
+		Commit,
+		Done
+	};
+
+	void RestoreProfile();
+	// Ends the bake before the commit with a dialog
+	void Fail(const FText& Message);
+	bool ArePartsValid() const;
+	void OnObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& Event);
+
+	void ShowNotification();
+	void UpdateNotification();
+	void EndNotification(const FText& Text, const SNotificationItem::ECompletionState State);
+
+	// Sparse verts and deduplicated frames, false when the textures do not fit
+	bool CompactGathered();
+	void LaunchEncode();
+	void Commit();
+
+	UDebugSkelMeshComponent* PreviewComponent;
+	TWeakObjectPtr <UDebugSkelMeshComponent> WeakPreviewComponent;
+	USkeletalMesh* PreviewMesh;
+	UVertexAnimProfile* Profile;
+	const bool bOnlyCreateStaticMesh;
+	FString PackageName;
+
+	bool DoAnimBake = false;
+	bool DoStaticMesh = false;
+
+	FVATBakeReport Report;
+
+	// Everything up to the commit only writes to the profile, a snapshot of it is enough to leave the assets untouched
+	TArray <uint8> ProfileBackup;
+	bool bProfileWasDirty = false;
+
+	// The preview mesh and the meshes following its pose are baked into one static mesh sharing the textures
+	TArray <USkinnedMeshComponent*> BakeComponents;
+	TArray <TWeakObjectPtr <USkinnedMeshComponent>> WeakBakeComponents;
+
+	bool bSparseVert = false;
+	bool bDedupFrames = false;
+
+	TArray <int32> UniqueSourceIDs;
+	TArray <TArray <FVector2D>> UVs_VertAnim;
+	TArray <TArray <FVector2D>> UVs_BoneAnim1;
+	TArray <TArray <FVector2D>> UVs_BoneAnim2;
+	TArray <TArray <FColor>> Colors_BoneAnim;
+
+	USkeleton* BakeSkeleton = NULL;
+	bool bReuseSharedBones = false;
+	TArray <UVertexAnimProfile*> SharedBoneAnimUsers;
+
+	int32 TextureWidth_Vert = 0;
+	int32 TextureHeight_Vert = 0;
+	int32 TextureWidth_Bone = 0;
+	int32 TextureHeight_Bone = 0;
+	int32 StoredRows_Bone = 0;
+
+	TUniquePtr <FVATPoseGather> Gather;
+	bool bGatherActive = false;
+	TArray <FVector4> VertPos, VertNormal, BonePos, BoneRot;
+
+	TArray <FFloat16Color> Data_Normals, Data_Offsets, Data_BoneRot, Data_BonePos;
+	TArray <uint16> Data_NormalsOctahedral;
+	TArray <uint16> Data_FrameRows_Vert, Data_FrameRows_Bone;
+	FIntPoint FrameRowSize_Vert, FrameRowSize_Bone;
+
+	// Seconds the encoding took
+	TFuture <double> EncodeResult;
+
+	EState State = EState::Gather;
+	// Modal dialogs and the slow task of the commit can tick the ticker again
+	bool bCommitting = false;
+	bool bCancelRequested = false;
+	bool bProfileEdited = false;
+	FDelegateHandle PropertyChangedHandle;
+	TSharedPtr <SNotificationItem> Notification;
+};
+
+// One bake at a time, it drives the preview scene
+static TWeakPtr <FVATBake> ActiveBake;
+static FDelegateHandle ActiveBakeTickHandle;
+
+FVATBake::FVATBake(UDebugSkelMeshComponent* InPreviewComponent, UVertexAnimProfile* InProfile, const bool bInOnlyCreateStaticMesh, const FString& InPackageName)
+	: PreviewComponent(InPreviewComponent)
+	, WeakPreviewComponent(InPreviewComponent)
+	, PreviewMesh(InPreviewComponent->SkeletalMesh)
+	, Profile(InProfile)
+	, bOnlyCreateStaticMesh(bInOnlyCreateStaticMesh)
+	, PackageName(InPackageName)
+{
+	DoAnimBake = (Profile != NULL) && !bOnlyCreateStaticMesh;
+	DoStaticMesh = (Profile != NULL);
+}
+
+FVATBake::~FVATBake()
+{
+	FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(PropertyChangedHandle);
+}
+
+void FVATBake::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	Collector.AddReferencedObject(Profile);
+	Collector.AddReferencedObjects(SharedBoneAnimUsers);
+}
+
+void FVATBake::RestoreProfile()
+{
+	FObjectReader BackupReader(Profile, ProfileBackup);
+	Profile->CacheBoneQueryData();
+	Profile->GetOutermost()->SetDirtyFlag(bProfileWasDirty);
+}
+
+void FVATBake::Fail(const FText& Message)
+{
+	RestoreProfile();
+	State = EState::Done;
+	EndNotification(LOCTEXT("BakeFailed", "Vertex Animation bake failed"), SNotificationItem::CS_Fail);
+	FMessageDialog::Open(EAppMsgType::Ok, Message);
+}
+
+// Persona can close or swap the preview mesh between editor ticks
+bool FVATBake::ArePartsValid() const
+{
+	if (!WeakPreviewComponent.IsValid() || (PreviewComponent->SkeletalMesh != PreviewMesh)) return false;
+
+	for (const TWeakObjectPtr <USkinnedMeshComponent>& Component : WeakBakeComponents)
+	{
+		if (!Component.IsValid()) return false;
+	}
+	return true;
+}
+
+// The gather and the layout keep pointers into the profile arrays, an edit of the profile ends the bake
+void FVATBake::OnObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& Event)
+{
+	if (Object == Profile) bProfileEdited = true;
+}
+
+void FVATBake::ShowNotification()
+{
+	TWeakPtr <FVATBake> WeakBake = AsShared();
+
+	FNotificationInfo Info(LOCTEXT("BakingVertexAnim", "Baking Vertex Animation"));
+	Info.bFireAndForget = false;
+	Info.bUseLargeFont = false;
+	Info.ExpireDuration = 3.0f;
+	Info.ButtonDetails.Add(FNotificationButtonInfo(
+		LOCTEXT("CancelBake", "Cancel"),
+		LOCTEXT("CancelBakeTooltip", "Cancels the bake, the Profile and its assets are left as they were"),
+		FSimpleDelegate::CreateLambda([WeakBake]()
+	{
+		if (TSharedPtr <FVATBake> Bake = WeakBake.Pin()) Bake->bCancelRequested = true;
+	}),
+		SNotificationItem::CS_Pending));
+
+	Notification = FSlateNotificationManager::Get().AddNotification(Info);
+	if (Notification.IsValid())
+	{
+		Notification->SetCompletionState(SNotificationItem::CS_Pending);
+	}
+}
+
+void FVATBake::UpdateNotification()
+{
+	if (!Notification.IsValid()) return;
+
+	if (State == EState::Gather)
+	{
+		Notification->SetText(FText::Format(LOCTEXT("BakingVertexAnimFrames", "Baking Vertex Animation, frame {0} of {1}"),
+			FText::AsNumber(Gather->GetNumFramesDone()), FText::AsNumber(Gather->GetNumFrames())));
+	}
+	else if (State == EState::Encode)
+	{
+		Notification->SetText(LOCTEXT("BakingVertexAnimEncode", "Baking Vertex Animation, encoding textures"));
+	}
+}
+
+void FVATBake::EndNotification(const FText& Text, const SNotificationItem::ECompletionState CompletionState)
+{
+	if (!Notification.IsValid()) return;
+
+	Notification->SetText(Text);
+	Notification->SetCompletionState(CompletionState);
+	Notification->ExpireAndFadeout();
+	Notification.Reset();
+}
+
+bool FVATBake::Start()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(VAT_Bake);
+	SCOPE_CYCLE_COUNTER(STAT_VAT_Bake);
+
+	FObjectWriter BackupWriter(Profile, ProfileBackup);
+	bProfileWasDirty = Profile->GetOutermost()->IsDirty();
+
+	Profile->SyncHybridAnims();
+
+	GetBakeMeshComponents(PreviewComponent, Profile->MergeFollowerMeshes, BakeComponents);
+	for (USkinnedMeshComponent* Component : BakeComponents)
+	{
+		WeakBakeComponents.Add(Component);
+	}
+
+	if (DoAnimBake && Profile->SparseVertAnim && (Profile->Anims_Vert.Num() > 0) && (Profile->NormalEncoding != EVANormalEncoding::Delta))
+	{
+		Fail(LOCTEXT("SparseVertAnimNeedsDelta", "Sparse Vert Anim needs the Delta Normal Encoding"));
+		return false;
+	}
 
-			{
+	// Sparse vert anims are compacted after the gather, the vert texture is only checked once it has its final size
+	bSparseVert = DoAnimBake && Profile->SparseVertAnim && (Profile->Anims_Vert.Num() > 0);
+	// Deduplicated frames need fewer rows, the heights are only checked once they are known
+	// Off until the material functions look the frame rows up
+	bDedupFrames = FVertexAnimDecoder::bMaterialsReadFrameRows && DoAnimBake && Profile->DeduplicateFrames;
 
-				for (int32 j = 0; j < Profile->Anims_Vert[i].NumFrames; j++)
-				{
-					const float AnimTime = Step_Vert * j;
+	{
+		{
+			VAT_BAKE_STAGE_SCOPE(Report, Layout, Meshes);
 
-					PreviewComponent->SetPosition(AnimTime, false);
-					PreviewComponent->RefreshBoneTransforms(nullptr);
-					PreviewComponent->RecreateClothingActors();
-					// Cloth Ticking
-					for (int32 P = 0; P < 8; P++) PreviewComponent->GetWorld()->Tick(ELevelTick::LEVELTICK_All, Step_Vert);
+			SkinnedMeshVATData(
+				BakeComponents,
+				Profile,
+				UniqueSourceIDs,
+				UVs_VertAnim,
+				UVs_BoneAnim1,
+				UVs_BoneAnim2,
+				Colors_BoneAnim);
+		}
 
-					PreviewComponent->ClearMotionVector();
+		if ((!bSparseVert && !bDedupFrames && (Profile->CalcTotalRequiredHeight_Vert() > Profile->OverrideSize_Vert.Y)) ||
+			(!bDedupFrames && (Profile->CalcTotalRequiredHeight_Bone() > Profile->OverrideSize_Bone.Y)))
+		{
+			Fail(LOCTEXT("SelectedProfileRequiresMoreHeight", "Selected Profile Requires More Texture Height"));
+			return false;
+		}
 
-					FlushRenderingCommands();
+		if ((!bSparseVert && ((bDedupFrames ? Profile->OverrideSize_Vert.X : Profile->OverrideSize_Vert.GetMax()) > 4096)) ||
+			((bDedupFrames ? Profile->OverrideSize_Bone.X : Profile->OverrideSize_Bone.GetMax()) > 4096))
+		{
+			Fail(LOCTEXT("TooMuch", "Warning: required texture size exceeds UE texture resolution limit, Mesh has too many vertices and/or Profile has too many animation frames"));
+			return false;
+		}
 
-					TArray <FFinalSkinVertex> FinalVerts;
-					FinalVerts = static_cast<FSkeletalMeshObjectCPUSkin*>(PreviewComponent->MeshObject)->GetCachedFinalVertices();
+		if (Profile->HybridBake && (UniqueSourceIDs.Num() == 0))
+		{
+			Fail(LOCTEXT("HybridMasksSelectNoVerts", "Hybrid Material Slots / Bones of the Profile select no vertices of the mesh"));
+			return false;
+		}
 
-					for (int32 k = 0; k < UniqueSourceIDs.Num(); k++)
-					{
-						const int32 IndexInZeroed = k;
-						const int32 VertID = UniqueSourceIDs[k];
-						const FVector Delta = FinalVerts[VertID].Position - RefPoseFinalVerts[VertID].Position;
-						MaxValueOffset = FMath::Max(Delta.GetAbsMax(), MaxValueOffset);
-						ZeroedPos[IndexInZeroed] = Delta;
-
-						const FVector DeltaNormal = FinalVerts[VertID].TangentZ.ToFVector() - RefPoseFinalVerts[VertID].TangentZ.ToFVector();
-						ZeroedNorm[IndexInZeroed] = DeltaNormal;
-					}
+		if (Profile->HybridBake)
+		{
+			NotifyBakeWarning(LOCTEXT("HybridNoMaterialBranch",
+				"Hybrid bake: bone only verts get a vert anim UV X of -1, the provided material functions do not skip them yet and read texel (-1, Y)"));
+		}
 
-					GridVertPos.Append(ZeroedPos);
-					GridVertNormal.Append(ZeroedNorm);
-				}
-			}
+		if (Profile->VertexIdAddressing && Profile->Anims_Vert.Num() && (UniqueSourceIDs.Num() > (int32)FVertexAnimDecoder::MaxPackedIndex + 1))
+		{
+			Fail(LOCTEXT("TooManyVertsForVertexId", "Mesh has too many unique vertices for Vertex Id Addressing, disable it in the Profile"));
+			return false;
 		}
 	}
 
+	// Bone anims the shared bone asset already holds are not baked again
+	BakeSkeleton = PreviewComponent->SkeletalMesh->Skeleton;
+	bReuseSharedBones = DoAnimBake && Profile->SharedBoneAnim && Profile->Anims_Bone.Num() &&
+		(Profile->Layers_Bone.Num() == 0) && Profile->SharedBoneAnim->HoldsClips(BakeSkeleton, Profile->Anims_Bone, Profile->OverrideSize_Bone) &&
+		(Profile->SharedBoneAnim->BoneNames_Generated == Profile->BoneNames_Generated);
 
-	// Bone Anim
-	if (Profile->Anims_Bone.Num())
+	// Baking into the shared bone asset overwrites the layout the other profiles using it copied
+	if (DoAnimBake && Profile->SharedBoneAnim && Profile->Anims_Bone.Num() && !bReuseSharedBones)
 	{
-		const auto& RefSkeleton = PreviewComponent->SkeletalMesh->RefSkeleton;
-		const auto& GlobalRefSkeleton = PreviewComponent->SkeletalMesh->Skeleton->GetReferenceSkeleton();
-		// Ref Pose in Row 0
-		{
-			PreviewComponent->EnablePreview(true, NULL);
-			PreviewComponent->RefreshBoneTransforms(nullptr);
-			PreviewComponent->ClearMotionVector();
-			FlushRenderingCommands();
-			PreviewComponent->CacheRefToLocalMatrices(RefToLocal);
+		GatherSharedBoneAnimUsers(Profile->SharedBoneAnim, Profile, SharedBoneAnimUsers);
 
-			for (int32 B = 0; B < RefSkeleton.GetNum(); B++)
-			{
-				FTransform RefTM = FAnimationRuntime::GetComponentSpaceTransformRefPose(RefSkeleton, B);
-				FQuat RefQuat = RefTM.GetRotation();
-				QuatSave(RefQuat);
-				const int32 GlobalID = GlobalRefSkeleton.FindBoneIndex(RefSkeleton.GetBoneName(B));
-				ZeroedBonePos[GlobalID] = RefTM.GetLocation();
-				ZeroedBoneRot[GlobalID] = FVector4(RefQuat.X, RefQuat.Y, RefQuat.Z, RefQuat.W);
-				//UE_LOG(LogUnrealMath, Warning, TEXT("%s"), *ZeroedBonePos[B].ToString());
-			}
-			GridBonePos.Append(ZeroedBonePos);
-			GridBoneRot.Append(ZeroedBoneRot);
+		FString OtherClipUsers;
+		for (const UVertexAnimProfile* User : SharedBoneAnimUsers)
+		{
+			if (!HaveSameClips(User->Anims_Bone, Profile->Anims_Bone)) OtherClipUsers += TEXT("\n") + User->GetPathName();
 		}
 
-		for (int32 i = 0; i < Profile->Anims_Bone.Num(); i++)
+		if (!OtherClipUsers.IsEmpty() && (FMessageDialog::Open(EAppMsgType::YesNo, FText::Format(
+			LOCTEXT("SharedBoneAnimOtherClips", "The Shared Bone Anim is used by Profiles with other Bone Anims, they decode wrong bone anims until they are baked again:{0}\n\nBake anyway?"),
+			FText::FromString(OtherClipUsers))) != EAppReturnType::Yes))
 		{
-			PreviewComponent->EnablePreview(true, Profile->Anims_Bone[i].SequenceRef);
-			UAnimSingleNodeInstance* SingleNodeInstance = PreviewComponent->GetSingleNodeInstance();
+			RestoreProfile();
+			return false;
+		}
+	}
 
-			const float Length = SingleNodeInstance->GetLength();
-			const float Step_Bone = Length / Profile->Anims_Bone[i].NumFrames;
+	TextureWidth_Vert = Profile->OverrideSize_Vert.X;
+	TextureHeight_Vert = Profile->OverrideSize_Vert.Y;
+	TextureWidth_Bone = Profile->OverrideSize_Bone.X;
+	TextureHeight_Bone = Profile->OverrideSize_Bone.Y;
+	StoredRows_Bone = Profile->CalcTotalRequiredHeight_Bone() + 1;
 
-			Profile->Anims_Bone[i].Speed_Generated = 1.f / Length;
-			Profile->Anims_Bone[i].AnimStart_Generated = Profile->CalcStartHeightOfAnim_Bone(i);
+	PropertyChangedHandle = FCoreUObjectDelegates::OnObjectPropertyChanged.AddSP(AsShared(), &FVATBake::OnObjectPropertyChanged);
+	ShowNotification();
 
-			for (int32 j = 0; j < Profile->Anims_Bone[i].NumFrames; j++)
-			{
-				const float AnimTime = Step_Bone * j;
+	// Pose evaluation and CPU skinning tick the preview scene, they stay on the game thread
+	if (DoAnimBake)
+	{
+		VAT_BAKE_STAGE_SCOPE(Report, Gather, Animation);
 
-				PreviewComponent->SetPosition(AnimTime, false);
-				PreviewComponent->RefreshBoneTransforms(nullptr);
-				PreviewComponent->ClearMotionVector();
-				FlushRenderingCommands();
+		Gather = MakeUnique <FVATPoseGather>(Profile, PreviewComponent, BakeComponents, UniqueSourceIDs, !bReuseSharedBones);
+		Gather->Begin();
+		bGatherActive = true;
+		State = EState::Gather;
+		UpdateNotification();
+	}
+	else
+	{
+		State = EState::Commit;
+	}
+
+	return true;
+}
 
+void FVATBake::Cancel(const FText& Reason)
+{
+	if (bCommitting || (State == EState::Done)) return;
 
-				PreviewComponent->CacheRefToLocalMatrices(RefToLocal);
+	if ((State == EState::Encode) && EncodeResult.IsValid()) EncodeResult.Wait();
 
-				{
-					for (int32 k = 0; k < RefToLocal.Num(); k++)
-					{
-						const int32 GlobalID = GlobalRefSkeleton.FindBoneIndex(RefSkeleton.GetBoneName(k));
+	if (bGatherActive && ArePartsValid()) Gather->End();
+	bGatherActive = false;
 
-						FVector Pos = RefToLocal[k].GetOrigin();
-						ZeroedBonePos[GlobalID] = Pos;
+	RestoreProfile();
+	EndNotification(Reason, SNotificationItem::CS_Fail);
+	State = EState::Done;
+}
 
-						MaxValuePosBone = FMath::Max(MaxValuePosBone, Pos.GetAbsMax());
+bool FVATBake::Tick(float DeltaTime)
+{
+	if (State == EState::Done) return false;
+	if (bCommitting) return true;
 
-						FQuat Q = RefToLocal[k].ToQuat();
-						QuatSave(Q);
-						ZeroedBoneRot[GlobalID] = FVector4(Q.X, Q.Y, Q.Z, Q.W);
-					}
-				}
+	// The encoding reads the gathered data, a cancelled bake waits for it
+	const bool bEncoding = (State == EState::Encode) && !EncodeResult.IsReady();
 
-				GridBonePos.Append(ZeroedBonePos);
-				GridBoneRot.Append(ZeroedBoneRot);
-			}
-		}
+	if (!bEncoding && !ArePartsValid())
+	{
+		Cancel(LOCTEXT("BakePreviewClosed", "Vertex Animation bake cancelled, the preview mesh changed or its editor was closed"));
+		return false;
 	}
-
-	// 4 Put Mesh back into ref pose
+	if (!bEncoding && bProfileEdited)
 	{
-		PreviewComponent->EnablePreview(true, NULL);
-		PreviewComponent->RefreshBoneTransforms(nullptr);
+		Cancel(LOCTEXT("BakeProfileEdited", "Vertex Animation bake cancelled, the Profile was edited during the bake and is restored to its state before it"));
+		return false;
+	}
+	if (!bEncoding && bCancelRequested)
+	{
+		Cancel(LOCTEXT("BakeCancelled", "Vertex Animation bake cancelled"));
+		return false;
+	}
 
-		PreviewComponent->ClearMotionVector();
-		
-		// switch back to non CPU skinning
+	if (State == EState::Gather)
+	{
 		{
-			// switch skinning mode, LOD etc. back
-			PreviewComponent->SetForcedLOD(0);
-			PreviewComponent->SetCPUSkinningEnabled(bCachedCPUSkinning, bRecreateRenderStateImmediately);
+			VAT_BAKE_STAGE_SCOPE(Report, Gather, Animation);
+
+			if (Gather->GatherNextFrame())
+			{
+				UpdateNotification();
+				return true;
+			}
+
+			Gather->End();
+			bGatherActive = false;
+			Gather->Finish(VertPos, VertNormal, BonePos, BoneRot);
+
+			if (bReuseSharedBones)
+			{
+				Profile->SharedBoneAnim->CopyToProfile(Profile);
+				CalcSharedBoneAnimBounds(Profile, BakeComponents);
+			}
 		}
 
-		FlushRenderingCommands();
+		if (!CompactGathered()) return false;
+
+		LaunchEncode();
+		State = EState::Encode;
+		UpdateNotification();
+		return true;
 	}
 
-	Profile->MaxValueOffset_Vert = MaxValueOffset;
-	Profile->MaxValuePosition_Bone = MaxValuePosBone;
+	if (State == EState::Encode)
+	{
+		if (bEncoding) return true;
 
-	Profile->MarkPackageDirty();
+		Report.EndStage(TEXT("Encode"), EncodeResult.Get());
+		State = EState::Commit;
+	}
 
-	OutGridVertPos = GridVertPos;
-	OutGridVertNormal = GridVertNormal;
-	OutGridBonePos = GridBonePos;
-	OutGridBoneRot = GridBoneRot;
+	bCommitting = true;
+	Commit();
+	bCommitting = false;
+	State = EState::Done;
+	return false;
 }
 
-
-static void EncodeData_Vec(const TArray <FVector4>& VectorData, const float MaxValue, const bool HDR, TArray <FFloat16Color>& Data)
+bool FVATBake::CompactGathered()
 {
-	for (int32 i = 0; i < VectorData.Num(); i++)
+	if (bSparseVert)
+	{
+		VAT_BAKE_STAGE_SCOPE(Report, Layout, Meshes);
+
+		const FIntPoint GatherSize_Vert = Profile->OverrideSize_Vert;
+		TArray <int32> TexelRemap;
+		CompactStaticVerts(Profile, UniqueSourceIDs.Num(), VertPos, VertNormal, TexelRemap);
+		RemapVertAnimUVs(Profile, GatherSize_Vert, TexelRemap, UVs_VertAnim);
+
+		if ((Profile->CalcTotalRequiredHeight_Vert() > Profile->OverrideSize_Vert.Y) ||
+			(Profile->OverrideSize_Vert.GetMax() > 4096))
+		{
+			Fail(LOCTEXT("TooMuch", "Warning: required texture size exceeds UE texture resolution limit, Mesh has too many vertices and/or Profile has too many animation frames"));
+			return false;
+		}
+
+		TextureWidth_Vert = Profile->OverrideSize_Vert.X;
+		TextureHeight_Vert = Profile->OverrideSize_Vert.Y;
+	}
+
+	if (bDedupFrames)
 	{
-		FVector VectorValue = VectorData[i];
-		const float MaxDim = VectorValue.GetAbsMax();
+		VAT_BAKE_STAGE_SCOPE(Report, Layout, Meshes);
 
-		if (MaxDim > 0.f)
+		// Normal deltas and rotations this close do not show in the shading
+		const float RotationTolerance = 1.f / 255.f;
+		TArray <int32> FrameMap;
+		bool bFits = true;
+
+		if (Profile->Anims_Vert.Num())
 		{
-			float Mag;
-			if (HDR)
-			{
-				VectorValue.X = VectorValue.X / MaxDim;
-				VectorValue.Y = VectorValue.Y / MaxDim;
-				VectorValue.Z = VectorValue.Z / MaxDim;
-				Mag = -1.0 + ((MaxDim / MaxValue) * 2.0);
+			const int32 StoredRows = Profile->RowsPerFrame_Vert * DeduplicateGridFrames(VertPos, VertNormal,
+				Profile->OverrideSize_Vert.X * Profile->RowsPerFrame_Vert, Profile->DeduplicateTolerance, RotationTolerance, FrameMap);
+			AssignFrameRows(Profile->Anims_Vert, FrameMap, 0, Profile->RowsPerFrame_Vert);
+			BuildFrameRowTable(Profile->Anims_Vert, 0, Profile->RowsPerFrame_Vert, Data_FrameRows_Vert, FrameRowSize_Vert);
+
+			if (Profile->AutoSize) Profile->OverrideSize_Vert.Y = FMath::RoundUpToPowerOfTwo(StoredRows);
+			bFits &= (StoredRows <= Profile->OverrideSize_Vert.Y) && (Profile->OverrideSize_Vert.GetMax() <= 4096);
+			TextureHeight_Vert = Profile->OverrideSize_Vert.Y;
+		}
 
-				Data[i] = FLinearColor(VectorValue.X, VectorValue.Y, VectorValue.Z, Mag);
-			}
-			else
+		// Row 0 holds the ref pose, it is always stored first and keeps its row
+		if (Profile->Anims_Bone.Num() && !bReuseSharedBones)
+		{
+			// Layer rows are addressed by frame and column, they move behind the stored anim rows as they are
+			const int32 AnimTexels_Bone = (Profile->CalcTotalNumOfFrames_Bone() + 1) * Profile->OverrideSize_Bone.X;
+			TArray <FVector4> LayerPos(BonePos.GetData() + AnimTexels_Bone, BonePos.Num() - AnimTexels_Bone);
+			TArray <FVector4> LayerRot(BoneRot.GetData() + AnimTexels_Bone, BoneRot.Num() - AnimTexels_Bone);
+			BonePos.SetNum(AnimTexels_Bone);
+			BoneRot.SetNum(AnimTexels_Bone);
+
+			StoredRows_Bone = DeduplicateGridFrames(BonePos, BoneRot,
+				Profile->OverrideSize_Bone.X, Profile->DeduplicateTolerance, RotationTolerance, FrameMap);
+			AssignFrameRows(Profile->Anims_Bone, FrameMap, 1, 1);
+			BuildFrameRowTable(Profile->Anims_Bone, 1, 1, Data_FrameRows_Bone, FrameRowSize_Bone);
+
+			for (FVABoneLayerData& Layer : Profile->Layers_Bone)
 			{
-				VectorValue.X = FVertexAnimUtils::EncodeFloat(VectorValue.X, MaxDim);
-				VectorValue.Y = FVertexAnimUtils::EncodeFloat(VectorValue.Y, MaxDim);
-				VectorValue.Z = FVertexAnimUtils::EncodeFloat(VectorValue.Z, MaxDim);
-				Mag = MaxDim / MaxValue;
+				Layer.Anim.AnimStart_Generated = StoredRows_Bone;
+				StoredRows_Bone += Layer.CalcNumRows();
+			}
+			BonePos.Append(LayerPos);
+			BoneRot.Append(LayerRot);
 
-				Data[i] = FLinearColor(VectorValue.X, VectorValue.Y, VectorValue.Z, Mag);
+			if (Profile->AutoSize)
+			{
+				Profile->OverrideSize_Bone.Y = FMath::RoundUpToPowerOfTwo(StoredRows_Bone);
 			}
+			bFits &= (StoredRows_Bone <= Profile->OverrideSize_Bone.Y) && (Profile->OverrideSize_Bone.GetMax() <= 4096);
+			TextureHeight_Bone = Profile->OverrideSize_Bone.Y;
+		}
+
+		if (!bFits)
+		{
+			Fail(LOCTEXT("TooMuch", "Warning: required texture size exceeds UE texture resolution limit, Mesh has too many vertices and/or Profile has too many animation frames"));
+			return false;
 		}
 	}
+
+	return true;
 }
 
-static void EncodeData_Quat(const bool HD, const TArray <FVector4>& VectorData, TArray <FFloat16Color>& Data)
+// Encoding only reads the gathered data and the profile values copied here, it runs on the thread pool
+void FVATBake::LaunchEncode()
 {
-	for (int32 i = 0; i < VectorData.Num(); i++)
+	if (Profile->Anims_Vert.Num())
+	{
+		switch (Profile->NormalEncoding)
+		{
+		case EVANormalEncoding::Delta:
+		case EVANormalEncoding::QTangent: Data_Normals.SetNumZeroed(TextureWidth_Vert * TextureHeight_Vert); break;
+		case EVANormalEncoding::Octahedral: Data_NormalsOctahedral.SetNumZeroed(TextureWidth_Vert * TextureHeight_Vert); break;
+		default: break;
+		}
+		Data_Offsets.SetNumZeroed(TextureWidth_Vert * TextureHeight_Vert);
+	}
+	if (Profile->Anims_Bone.Num() && !bReuseSharedBones)
+	{
+		Data_BoneRot.SetNumZeroed(TextureWidth_Bone * TextureHeight_Bone);
+		Data_BonePos.SetNumZeroed(TextureWidth_Bone * TextureHeight_Bone);
+	}
+
+	const EVANormalEncoding NormalEncoding = Profile->NormalEncoding;
+	const float MaxValueOffset_Vert = Profile->MaxValueOffset_Vert;
+	const float MaxValuePosition_Bone = Profile->MaxValuePosition_Bone;
+
+	EncodeResult = Async(EAsyncExecution::ThreadPool, [this, NormalEncoding, MaxValueOffset_Vert, MaxValuePosition_Bone]()
 	{
-		FVector4 VectorValue = VectorData[i];
-		uint8 BigComp = 0;
-		float Max = -100.0;
-		FVector WinnerValue;
+		TRACE_CPUPROFILER_EVENT_SCOPE(VATBake_Encode);
+		SCOPE_CYCLE_COUNTER(STAT_VATBake_Encode);
+		LLM_SCOPE(ELLMTag::Textures);
+		const double EncodeStartTime = FPlatformTime::Seconds();
+
+		ParallelFor(4, [&](int32 TextureIndex)
+		{
+			switch (TextureIndex)
+			{
+			case 0:
+				if (Data_Normals.Num() && (NormalEncoding == EVANormalEncoding::QTangent)) EncodeData_QTangent(VertNormal, Data_Normals);
+				else if (Data_Normals.Num()) EncodeData_Vec(VertNormal, 2.f, false, Data_Normals); // decided on fixed 2.0 for simplicity
+				if (Data_NormalsOctahedral.Num()) EncodeData_Octahedral16(VertNormal, Data_NormalsOctahedral);
+				break;
+			case 1:
+				if (Data_Offsets.Num() && (NormalEncoding == EVANormalEncoding::OctahedralInOffsets))
+				{
+					EncodeData_OffsetsOctahedral(VertPos, VertNormal, MaxValueOffset_Vert, Data_Offsets);
+				}
+				else if (Data_Offsets.Num())
+				{
+					EncodeData_Vec(VertPos, MaxValueOffset_Vert, true, Data_Offsets);
+				}
+				break;
+			case 2: if (Data_BoneRot.Num()) EncodeData_Quat(true, BoneRot, Data_BoneRot); break;
+			case 3: if (Data_BonePos.Num()) EncodeData_Vec(BonePos, MaxValuePosition_Bone, true, Data_BonePos); break;
+			}
+		});
 
-		bool Bit0 = false;
-		bool Bit1 = false;
+		return FPlatformTime::Seconds() - EncodeStartTime;
+	});
+}
+
+// From here on assets are written and the bake can no longer be cancelled
+void FVATBake::Commit()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(VAT_Bake);
+	SCOPE_CYCLE_COUNTER(STAT_VAT_Bake);
+
+	FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(PropertyChangedHandle);
+
+	// The asset builds need the game thread in this engine version
+	FScopedSlowTask SlowTask(2.f, LOCTEXT("BakeCommit", "Writing the baked static mesh and textures"));
+	SlowTask.MakeDialog();
+
+	if (DoStaticMesh)
+	{
+		SlowTask.EnterProgressFrame(1.f, LOCTEXT("BakeStaticMesh", "Building static mesh"));
+		VAT_BAKE_STAGE_SCOPE(Report, StaticMesh, StaticMesh);
 
-		if (FMath::Abs(VectorValue[0]) > Max)
+		if (Profile->StaticMesh && (!bOnlyCreateStaticMesh))
 		{
-			BigComp = 0;
-			Bit0 = 0, Bit1 = 0;
-			Max = FMath::Abs(VectorValue[0]);
-			WinnerValue = FVector(VectorValue[1], VectorValue[2], VectorValue[3]);
+			PackageName = Profile->StaticMesh->GetOutermost()->GetName();
 		}
-		if (FMath::Abs(VectorValue[1]) > Max)
+		else
 		{
-			BigComp = 1;
-			Bit0 = 0, Bit1 = 1;
-			Max = FMath::Abs(VectorValue[1]);
-			WinnerValue = FVector(VectorValue[0], VectorValue[2], VectorValue[3]);
+			FString AssetName = Profile->GetOutermost()->GetName();
+			//FString Name = Profile->GetName();
+			FString Name = PreviewComponent->SkeletalMesh->GetName();
+			//FString AssetName = PreviewComponent->SkeletalMesh->GetOutermost()->GetName();
+			const FString SanitizedBasePackageName = UPackageTools::SanitizePackageName(AssetName);
+			const FString PackagePath = FPackageName::GetLongPackagePath(SanitizedBasePackageName) + TEXT("/") + Name + TEXT("_VAT");
+			PackageName = PackagePath;
 		}
-		if (FMath::Abs(VectorValue[2]) > Max)
+
+		// All VAT channels go into the source models so the mesh is built once
+		FVATStaticMeshChannels VATChannels;
+		if (Profile->UVComponent_VertAnim == 1)
 		{
-			BigComp = 2;
-			Bit0 = 1, Bit1 = 0;
-			Max = FMath::Abs(VectorValue[2]);
-			WinnerValue = FVector(VectorValue[0], VectorValue[1], VectorValue[3]);
+			for (int32 LOD = 0; LOD < UVs_BoneAnim1.Num(); LOD++)
+			{
+				for (int32 v = 0; v < UVs_BoneAnim1[LOD].Num(); v++) UVs_BoneAnim1[LOD][v].Y = UVs_VertAnim[LOD][v].X;
+			}
 		}
-		if (FMath::Abs(VectorValue[3]) > Max)
+		else
 		{
-			BigComp = 3;
-			Bit0 = 1, Bit1 = 1;
-			Max = FMath::Abs(VectorValue[3]);
-			WinnerValue = FVector(VectorValue[0], VectorValue[1], VectorValue[2]);
+			VATChannels.AddUVs(Profile->UVChannel_VertAnim, UVs_VertAnim);
 		}
-
-		if (VectorValue[BigComp] < 0)
+		VATChannels.AddUVs(Profile->UVChannel_BoneAnim, UVs_BoneAnim1);
+		if (Profile->UVChannel_BoneAnim_Full != -1)
 		{
-			WinnerValue *= -1.0;
+			VATChannels.AddUVs(Profile->UVChannel_BoneAnim_Full, UVs_BoneAnim2);
+			VATChannels.Colors = &Colors_BoneAnim;
 		}
 
-		const float MaxDim = WinnerValue.GetAbsMax();
-		// for now no bit based encoding, just have quats be always HDR (double precission).
-		if (false)
+		const TArray <UMeshComponent*> MeshComponents(BakeComponents);
+		Report.MeshOrder.bVertexCache = Profile->OptimizeVertexCache;
+		Report.MeshOrder.bOverdraw = Profile->OptimizeOverdraw;
+		UStaticMesh* StaticMesh = FVertexAnimUtils::ConvertMeshesToStaticMesh(MeshComponents, FTransform::Identity, PackageName, &VATChannels,
+			(Profile->OptimizeVertexCache || Profile->OptimizeOverdraw) ? &Report.MeshOrder : NULL);
+
+		Profile->StaticMesh = StaticMesh;
+		Profile->MarkPackageDirty();
+	}
+
+	if (DoAnimBake)
+	{
+		SlowTask.EnterProgressFrame(1.f, LOCTEXT("BakeTextures", "Building textures"));
+
+		ApplyAnimatedBoundsToStaticMesh(Profile);
+
+		FString AssetName = Profile->GetOutermost()->GetName();
+		const FString SanitizedBasePackageName = UPackageTools::SanitizePackageName(AssetName);
+		const FString PackagePath = FPackageName::GetLongPackagePath(SanitizedBasePackageName) + TEXT("/");
+
+		// Vert Textures
+		if(Profile->Anims_Vert.Num())
 		{
-			/*
-			if (MaxDim > 0.f)
+			VAT_BAKE_STAGE_SCOPE(Report, Textures_Vert, Textures);
+
+			// Normals packed in the offsets have no texture of their own
+			if (Profile->NormalEncoding == EVANormalEncoding::OctahedralInOffsets)
 			{
-				FVector4 Encoded = FVertexAnimUtils::BitEncodeVecId_HD(WinnerValue, 1.0, BigComp);
-				if(HD)
-					Data[i] = FLinearColor(Encoded);
-				else 
-					Data[i] = FLinearColor(FVertexAnimUtils::BitEncodeVecId(WinnerValue, 1.0, BigComp));
-
-				UE_LOG(LogUnrealMath, Warning, TEXT("Vec Value %s || Id %i || Result Encode %s"), 
-					*WinnerValue.ToString(), BigComp, *Encoded.ToString());
+				Profile->NormalsTexture = NULL;
 			}
 			else
 			{
-				Data[i] = FLinearColor(0, 0, 0, 1);
-			}*/
+				const bool bOctahedral = Profile->NormalEncoding == EVANormalEncoding::Octahedral;
+				Profile->NormalsTexture = SetTextureSource(PreviewComponent->GetWorld(), PackagePath,
+					Profile->GetName() + "_Normals", Profile->NormalsTexture,
+					TextureWidth_Vert, TextureHeight_Vert,
+					bOctahedral ? (const void*)Data_NormalsOctahedral.GetData() : (const void*)Data_Normals.GetData(),
+					bOctahedral ? TSF_G16 : TSF_RGBA16F,
+					Profile->GetMaskedFlags() | RF_Public | RF_Standalone);
+
+				if (bOctahedral)
+				{
+					SetG16TextureSettings(Profile->NormalsTexture);
+				}
+				else
+				{
+					Profile->NormalsTexture->Filter = TextureFilter::TF_Nearest;
+					Profile->NormalsTexture->NeverStream = true;
+					// QTangents need the half floats
+					Profile->NormalsTexture->CompressionSettings = (Profile->NormalEncoding == EVANormalEncoding::QTangent) ?
+						TextureCompressionSettings::TC_HDR : TextureCompressionSettings::TC_VectorDisplacementmap;
+					Profile->NormalsTexture->SRGB = false;
+					Profile->NormalsTexture->Modify();
+					Profile->NormalsTexture->MarkPackageDirty();
+					Profile->NormalsTexture->PostEditChange();
+					Profile->NormalsTexture->UpdateResource();
+				}
+			}
+
+
+			{
+				Profile->OffsetsTexture = SetTexture2(PreviewComponent->GetWorld(), PackagePath,
+					Profile->GetName() + "_Offsets", Profile->OffsetsTexture,
+					TextureWidth_Vert, TextureHeight_Vert,
+					Data_Offsets,
+					Profile->GetMaskedFlags() | RF_Public | RF_Standalone);
+
+				Profile->OffsetsTexture->Filter = TextureFilter::TF_Nearest;
+				Profile->OffsetsTexture->NeverStream = true;
+				Profile->OffsetsTexture->CompressionSettings = TextureCompressionSettings::TC_HDR;
+				Profile->OffsetsTexture->SRGB = false;
+				Profile->OffsetsTexture->Modify();
+				Profile->OffsetsTexture->MarkPackageDirty();
+				Profile->OffsetsTexture->PostEditChange();
+				Profile->OffsetsTexture->UpdateResource();
+			}
+
+			Profile->FrameRowTexture_Vert = Data_FrameRows_Vert.Num() ? SetIndexTableTexture(PreviewComponent->GetWorld(), PackagePath,
+				Profile->GetName() + "_FrameRows", Profile->FrameRowTexture_Vert, FrameRowSize_Vert, Data_FrameRows_Vert,
+				Profile->GetMaskedFlags() | RF_Public | RF_Standalone) : NULL;
+		
 		}
-		else
+
+		// Bone Textures
+		if (Profile->Anims_Bone.Num() && !bReuseSharedBones)
 		{
-			if (MaxDim > 0.f) 
-			{
-			
-				float R = FMath::Max(0.001f, FVertexAnimUtils::EncodeFloat(WinnerValue.X, MaxDim)) * (Bit0 ? 1.0 : -1.0);
-				//R = FVertexAnimUtils::EncodeFloat(R * (Bit0 ? 1.0 : -1.0), 1.0);
+			VAT_BAKE_STAGE_SCOPE(Report, Textures_Bone, Textures);
 
-				float G = FMath::Max(0.001f, FVertexAnimUtils::EncodeFloat(WinnerValue.Y, MaxDim)) * (Bit1 ? 1.0 : -1.0);
-				//G = FVertexAnimUtils::EncodeFloat(G * (Bit1 ? 1.0 : -1.0), 1.0);
+			// Next to the shared bone asset when there is one
+			UVertexAnimBoneAsset* SharedBoneAnim = Profile->SharedBoneAnim;
+			UObject* BoneTextureOwner = SharedBoneAnim ? (UObject*)SharedBoneAnim : (UObject*)Profile;
+			const FString BonePackagePath = SharedBoneAnim ?
+				FPackageName::GetLongPackagePath(UPackageTools::SanitizePackageName(SharedBoneAnim->GetOutermost()->GetName())) + TEXT("/") : PackagePath;
+
+			{
+				Profile->BoneRotTexture = SetTexture2(PreviewComponent->GetWorld(), BonePackagePath, 
+					BoneTextureOwner->GetName() + "_BoneRot", SharedBoneAnim ? SharedBoneAnim->BoneRotTexture : Profile->BoneRotTexture,
+					TextureWidth_Bone, TextureHeight_Bone, 
+					Data_BoneRot,
+					BoneTextureOwner->GetMaskedFlags() | RF_Public | RF_Standalone);
 
-				float B = WinnerValue.Z / MaxDim;// FVertexAnimUtils::EncodeFloat(WinnerValue.Z, MaxDim);
+				SetBoneTextureSettings(Profile->BoneRotTexture);
+			}
 
-				float A = -1.0 + ((MaxDim / 1.0) * 2.0);// 
+			{
+				Profile->BonePosTexture = SetTexture2(PreviewComponent->GetWorld(), BonePackagePath,
+					BoneTextureOwner->GetName() + "_BonePos", SharedBoneAnim ? SharedBoneAnim->BonePosTexture : Profile->BonePosTexture,
+					TextureWidth_Bone, TextureHeight_Bone, 
+					Data_BonePos,
+					BoneTextureOwner->GetMaskedFlags() | RF_Public | RF_Standalone);
 
-				Data[i] = FLinearColor(R, G, B, A);
+				SetBoneTextureSettings(Profile->BonePosTexture);
 			}
-			else
+
+			Profile->FrameRowTexture_Bone = Data_FrameRows_Bone.Num() ? SetIndexTableTexture(PreviewComponent->GetWorld(), BonePackagePath,
+				BoneTextureOwner->GetName() + "_BoneFrameRows", SharedBoneAnim ? SharedBoneAnim->FrameRowTexture_Bone : Profile->FrameRowTexture_Bone,
+				FrameRowSize_Bone, Data_FrameRows_Bone,
+				BoneTextureOwner->GetMaskedFlags() | RF_Public | RF_Standalone) : NULL;
+
+			// With the bone textures, the layer rows are part of them
+			UTexture2D* PreviousLayerTable = Profile->LayerTableTexture_Bone;
+			Profile->LayerTableTexture_Bone = NULL;
+			if (Profile->Layers_Bone.Num())
 			{
-				Data[i] = FLinearColor(0, 0, 0, 1);
+				const FIntPoint LayerTableSize(TextureWidth_Bone, Profile->Layers_Bone.Num() * 2);
+				TArray <uint16> Data_LayerTable;
+				Data_LayerTable.SetNumZeroed(LayerTableSize.X * LayerTableSize.Y);
+				for (int32 L = 0; L < Profile->Layers_Bone.Num(); L++)
+				{
+					const FVABoneLayerData& Layer = Profile->Layers_Bone[L];
+					for (int32 k = 0; k < Layer.Columns_Generated.Num(); k++)
+					{
+						Data_LayerTable[(L * 2 * TextureWidth_Bone) + Layer.Columns_Generated[k]] = (uint16)(k + 1);
+						Data_LayerTable[(((L * 2) + 1) * TextureWidth_Bone) + Layer.Columns_Generated[k]] = (uint16)(Layer.AttachColumns_Generated[k] + 1);
+					}
+				}
+
+				Profile->LayerTableTexture_Bone = SetIndexTableTexture(PreviewComponent->GetWorld(), BonePackagePath,
+					BoneTextureOwner->GetName() + "_BoneLayers", PreviousLayerTable, LayerTableSize, Data_LayerTable,
+					BoneTextureOwner->GetMaskedFlags() | RF_Public | RF_Standalone);
 			}
-		}
-	}
-}
 
-static UTexture2D* SetTexture2(
-	UWorld* World, const FString PackagePath, const FString Name, 
-	UTexture2D* Texture, 
-	const int32 InSizeX, const int32 InSizeY,
-	const TArray <FFloat16Color>& Data, //const TArray <FVector>& VectorData,
-	EObjectFlags InObjectFlags)
-{
-	UTexture2D* NewTexture;
+			// CPU copy of the used columns and rows for the socket queries
+			const int32 UsedColumns_Bone = FMath::Min(Profile->BoneNames_Generated.Num(), TextureWidth_Bone);
+			const int32 UsedRows_Bone = FMath::Min(StoredRows_Bone, TextureHeight_Bone);
+			Profile->BoneRotData_CPU.Init(UsedColumns_Bone, UsedRows_Bone, Data_BoneRot, TextureWidth_Bone);
+			Profile->BonePosData_CPU.Init(UsedColumns_Bone, UsedRows_Bone, Data_BonePos, TextureWidth_Bone);
 
-	{
-		
-		if (Texture != NULL)
-		{
-			NewTexture = NewObject<UTexture2D>(Texture->GetOuter(), FName(*Texture->GetName()), InObjectFlags);
-			
-		}
-		else
-		{
-			UPackage* Package = CreatePackage(NULL, *(PackagePath + Name));
-			check(Package);
-			Package->FullyLoad();
+			Profile->CacheBoneQueryData();
+			Profile->MarkPackageDirty();
 
-			NewTexture = NewObject<UTexture2D>(Package, *Name, InObjectFlags);
+			if (SharedBoneAnim)
+			{
+				SharedBoneAnim->CopyFromProfile(Profile, BakeSkeleton);
+				SharedBoneAnim->MarkPackageDirty();
 
-			FAssetRegistryModule::AssetCreated(NewTexture);
+				// Users with the same clips and bone columns read the new textures as they are, the others need a bake of their own
+				FString StaleUsers;
+				for (UVertexAnimProfile* User : SharedBoneAnimUsers)
+				{
+					if (SharedBoneAnim->HoldsClips(BakeSkeleton, User->Anims_Bone, User->OverrideSize_Bone) &&
+						(SharedBoneAnim->BoneNames_Generated == User->BoneNames_Generated))
+					{
+						User->Modify();
+						SharedBoneAnim->CopyToProfile(User);
+						User->MarkPackageDirty();
+					}
+					else
+					{
+						StaleUsers += TEXT("\n") + User->GetPathName();
+					}
+				}
+
+				if (!StaleUsers.IsEmpty())
+				{
+					FMessageDialog::Open(EAppMsgType::Ok, FText::Format(
+						LOCTEXT("SharedBoneAnimStaleUsers", "The Shared Bone Anim no longer matches the layout of these Profiles, bake them again:{0}"),
+						FText::FromString(StaleUsers)));
+				}
+			}
 		}
 
-		checkf(NewTexture, TEXT("%s"), *Name);
+	}
 
-		NewTexture->Source.Init(InSizeX, InSizeY, /*NumSlices=*/ 1, /*NumMips=*/ 1, TSF_RGBA16F);
-		uint32* TextureData = (uint32*)NewTexture->Source.LockMip(0);
-		const int32 TextureDataSize = NewTexture->Source.CalcMipSize(0);
-		
-		FMemory::Memcpy(TextureData, Data.GetData(), TextureDataSize); // this did not blow up 
-		
-		NewTexture->Source.UnlockMip(0);
+	// Mirror columns follow the columns of the profile, shared bone textures included
+	if (DoAnimBake && Profile->Anims_Bone.Num())
+	{
+		Profile->BuildMirrorColumns();
+
+		if (Profile->MirrorColumns_Generated.Num())
+		{
+			FString AssetName = Profile->GetOutermost()->GetName();
+			const FString PackagePath = FPackageName::GetLongPackagePath(UPackageTools::SanitizePackageName(AssetName)) + TEXT("/");
+
+			const FIntPoint MirrorSize(FMath::Max((int32)FMath::RoundUpToPowerOfTwo(Profile->MirrorColumns_Generated.Num()), 8), 1);
+			TArray <uint16> Data_MirrorColumns;
+			Data_MirrorColumns.SetNumZeroed(MirrorSize.X);
+			for (int32 C = 0; C < Profile->MirrorColumns_Generated.Num(); C++)
+			{
+				Data_MirrorColumns[C] = (uint16)Profile->MirrorColumns_Generated[C];
+			}
 
-		NewTexture->PostEditChange();
+			Profile->MirrorColumnTexture = SetIndexTableTexture(PreviewComponent->GetWorld(), PackagePath,
+				Profile->GetName() + "_MirrorColumns", Profile->MirrorColumnTexture, MirrorSize, Data_MirrorColumns,
+				Profile->GetMaskedFlags() | RF_Public | RF_Standalone);
+		}
+		else
+		{
+			Profile->MirrorColumnTexture = NULL;
+		}
 
-		NewTexture->MarkPackageDirty();
+		Profile->MarkPackageDirty();
 	}
 
-	return NewTexture;
-}
+	if (Profile->Anims_Vert.Num() && UVs_VertAnim.Num())
+	{
+		TArray <uint32> Indices;
+		GetMergedIndexBuffer(BakeComponents, 0, Indices);
+		Report.VertFetchMissRate = SimulateVertFetchMissRate(Profile, Indices, UVs_VertAnim[0]);
+	}
 
-float FVATEditorUtils::PackBits(const uint32& bit)
-{
-	/*
-	int32 f16 = bit;
-	f16 += 1024;
-	int32 sign = (f16 & (0x8000)) << 16;
-	int32 expVar = ((((f16 >> 10) & 0x1f) - 15 + 127) << 23);
-	int32 mant = (f16 & 0x3ff) << 13;
-	f16 = (sign | expVar) | mant;
-	return f16;
-	*/
-
-	uint32 f16 = static_cast<uint32>(bit);
-	f16 += 1024;
-	uint32 sign = (f16 & (0x8000)) << 16;
-	uint32 expVar = //(f16 & 0x7fff) == 0 ? 0 : 
-		(/*shift*/((/*bit. and*/ (/*bit.shift*/ f16 >> 10) & 0x1f) - 15 + 127) << 23);
-
-	uint32 mant = (f16 & 0x3ff) << 13;
-	f16 = /*bit. or*/ (/*bit. or*/ sign | expVar) | mant;
-	//return f16;
-	//UE_LOG(LogUnrealMath, Warning, TEXT("HH %i || %i"), bit, f16); // printing 0
-	//return f16;// asfloat_O(f16);
-	return static_cast<float>(f16);
-}
+	Report.Write(Profile,
+		UVs_VertAnim.Num() ? UVs_VertAnim[0].Num() : 0, UniqueSourceIDs.Num(),
+		PreviewComponent->SkeletalMesh->RefSkeleton.GetNum(), UVs_VertAnim.Num());
 
-int FVATEditorUtils::UnPackBits(const float N)
-{
-	uint32 uRes32 = static_cast<uint32>(N);// asuint(N);
-	const uint32 sign2 = ((uRes32 >> 16) & 0x8000);
-	const uint32 exp2 = ((((const int)((uRes32 >> 23) & 0xff)) - 127 + 15) << 10);
-	const uint32 mant2 = ((uRes32 >> 13) & 0x3ff);
-	const uint32 bits = (sign2 | exp2 | mant2);
-	const uint32 result = bits - 1024;
-	return float(result);
+	EndNotification(LOCTEXT("BakeDone", "Vertex Animation baked"), SNotificationItem::CS_Success);
 }
 
 void FVATEditorUtils::DoBakeProcess(UDebugSkelMeshComponent* PreviewComponent)
 {
+	if (ActiveBake.IsValid())
+	{
+		FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("BakeAlreadyRunning", "A Vertex Animation bake is already running, wait for it to end or cancel it"));
+		return;
+	}
+
 	PreviewComponent->GlobalAnimRateScale = 0.f;
 	
 	UVertexAnimProfile* Profile = NULL;
@@ -883,7 +3378,8 @@ void FVATEditorUtils::DoBakeProcess(UDebugSkelMeshComponent* PreviewComponent)
 		TSharedPtr<SPickAssetDialog> PickAssetPathWidget =
 			SNew(SPickAssetDialog)
 			.Title(LOCTEXT("BakeAnimDialog", "Bake Anim Dialog"))
-			.DefaultAssetPath(FText::FromString(PackageNameSuggestion));
+			.DefaultAssetPath(FText::FromString(PackageNameSuggestion))
+			.Skeleton(PreviewComponent->SkeletalMesh ? PreviewComponent->SkeletalMesh->Skeleton : NULL);
 
 		if (PickAssetPathWidget->ShowModal() == EAppReturnType::Ok)
 		{
@@ -910,186 +3406,157 @@ void FVATEditorUtils::DoBakeProcess(UDebugSkelMeshComponent* PreviewComponent)
 
 	if ((!DoAnimBake) && (!DoStaticMesh)) return;
 
-	TArray <int32> UniqueSourceIDs;
-	TArray <TArray <FVector2D>> UVs_VertAnim;
-	TArray <TArray <FVector2D>> UVs_BoneAnim1;
-	TArray <TArray <FVector2D>> UVs_BoneAnim2;
-	TArray <TArray <FColor>> Colors_BoneAnim;
+	TSharedRef <FVATBake> Bake = MakeShared <FVATBake>(PreviewComponent, Profile, bOnlyCreateStaticMesh, PackageName);
+	if (!Bake->Start()) return;
 
+	ActiveBake = Bake;
+	ActiveBakeTickHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Bake](float DeltaTime)
 	{
-		{
-			SkinnedMeshVATData(
-				PreviewComponent,
-				Profile,
-				UniqueSourceIDs,
-				UVs_VertAnim,
-				UVs_BoneAnim1,
-				UVs_BoneAnim2,
-				Colors_BoneAnim);
-		}
-
-		if ((Profile->CalcTotalRequiredHeight_Vert() > Profile->OverrideSize_Vert.Y) ||
-			(Profile->CalcTotalRequiredHeight_Bone() > Profile->OverrideSize_Bone.Y))
-		{
-			FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("SelectedProfileRequiresMoreHeight", "Selected Profile Requires More Texture Height"));
-			return;
-		}
-
-		if ((Profile->OverrideSize_Vert.GetMax() > 4096) ||
-			(Profile->OverrideSize_Bone.GetMax() > 4096))
-		{
-			FMessageDialog::Open(EAppMsgType::Ok,
-				LOCTEXT("TooMuch", "Warning: required texture size exceeds UE texture resolution limit, Mesh has too many vertices and/or Profile has too many animation frames"));
-			return;
-		}
-	}
-
+		return Bake->Tick(DeltaTime);
+	}));
+}
 
-	if (DoStaticMesh)
+void FVATEditorUtils::CancelBake()
+{
+	if (TSharedPtr <FVATBake> Bake = ActiveBake.Pin())
 	{
-		if (Profile->StaticMesh && (!bOnlyCreateStaticMesh))
-		{
-			PackageName = Profile->StaticMesh->GetOutermost()->GetName();
-		}
-		else
-		{
-			FString AssetName = Profile->GetOutermost()->GetName();
-			//FString Name = Profile->GetName();
-			FString Name = PreviewComponent->SkeletalMesh->GetName();
-			//FString AssetName = PreviewComponent->SkeletalMesh->GetOutermost()->GetName();
-			const FString SanitizedBasePackageName = UPackageTools::SanitizePackageName(AssetName);
-			const FString PackagePath = FPackageName::GetLongPackagePath(SanitizedBasePackageName) + TEXT("/") + Name + TEXT("_VAT");
-			PackageName = PackagePath;
-		}
+		Bake->Cancel(LOCTEXT("BakeCancelled", "Vertex Animation bake cancelled"));
+		FTicker::GetCoreTicker().RemoveTicker(ActiveBakeTickHandle);
+	}
+}
 
-		UStaticMesh* StaticMesh = FVertexAnimUtils::ConvertMeshesToStaticMesh( { PreviewComponent }, FTransform::Identity, PackageName);
+void FVATBakeReport::Write(const UVertexAnimProfile* Profile, const int32 NumVerts, const int32 NumUniqueVerts, const int32 NumBones, const int32 NumLODs) const
+{
+	const double TotalSeconds = FPlatformTime::Seconds() - StartTime;
 
-		if (Profile->UVChannel_VertAnim != -1) FVertexAnimUtils::VATUVsToStaticMeshLODs(StaticMesh, Profile->UVChannel_VertAnim, UVs_VertAnim);
-		if (Profile->UVChannel_BoneAnim != -1) FVertexAnimUtils::VATUVsToStaticMeshLODs(StaticMesh, Profile->UVChannel_BoneAnim, UVs_BoneAnim1);
-		if (Profile->UVChannel_BoneAnim_Full != -1)
-		{
-			FVertexAnimUtils::VATUVsToStaticMeshLODs(StaticMesh, Profile->UVChannel_BoneAnim_Full, UVs_BoneAnim2);
-			FVertexAnimUtils::VATColorsToStaticMeshLODs(StaticMesh, Colors_BoneAnim);
-		}
+	TSharedPtr<FJsonObject> JsonReport = MakeShareable(new FJsonObject);
+	JsonReport->SetStringField(TEXT("Profile"), Profile->GetPathName());
+	JsonReport->SetStringField(TEXT("Date"), FDateTime::Now().ToIso8601());
+	JsonReport->SetNumberField(TEXT("TotalSeconds"), TotalSeconds);
 
-		Profile->StaticMesh = StaticMesh;
-		Profile->MarkPackageDirty();
+	TSharedPtr<FJsonObject> JsonStages = MakeShareable(new FJsonObject);
+	for (const TPair<FString, double>& Stage : StageSeconds)
+	{
+		JsonStages->SetNumberField(Stage.Key, Stage.Value);
 	}
-
-	
-
-	if (DoAnimBake)
+	JsonReport->SetObjectField(TEXT("StageSeconds"), JsonStages);
+
+	// UsedPhysical sampled at the end of every stage, the process wide peak is reported as well
+	JsonReport->SetNumberField(TEXT("StartUsedPhysicalMB"), StartUsedPhysical / (1024.0 * 1024.0));
+	JsonReport->SetNumberField(TEXT("PeakUsedPhysicalMB"), PeakUsedPhysical / (1024.0 * 1024.0));
+	JsonReport->SetNumberField(TEXT("ProcessPeakUsedPhysicalMB"), FPlatformMemory::GetStats().PeakUsedPhysical / (1024.0 * 1024.0));
+
+	JsonReport->SetNumberField(TEXT("Verts"), NumVerts);
+	JsonReport->SetNumberField(TEXT("UniqueVerts"), NumUniqueVerts);
+	JsonReport->SetNumberField(TEXT("Bones"), NumBones);
+	JsonReport->SetNumberField(TEXT("BoneColumns"), Profile->BoneNames_Generated.Num());
+	JsonReport->SetNumberField(TEXT("LODs"), NumLODs);
+	JsonReport->SetNumberField(TEXT("Anims_Vert"), Profile->Anims_Vert.Num());
+	JsonReport->SetNumberField(TEXT("Anims_Bone"), Profile->Anims_Bone.Num());
+	JsonReport->SetNumberField(TEXT("Layers_Bone"), Profile->Layers_Bone.Num());
+	JsonReport->SetNumberField(TEXT("Frames_Vert"), Profile->CalcTotalNumOfFrames_Vert());
+	JsonReport->SetNumberField(TEXT("Frames_Bone"), Profile->CalcTotalNumOfFrames_Bone());
+	JsonReport->SetNumberField(TEXT("StoredFrames_Vert"), Profile->CalcNumStoredFrames_Vert());
+	JsonReport->SetNumberField(TEXT("StoredFrames_Bone"), Profile->CalcNumStoredFrames_Bone());
+
+	// Wasted texels are the ones no vert or bone frame is written to
+	if (Profile->Anims_Vert.Num())
 	{
-		int32 TextureWidth_Vert = Profile->OverrideSize_Vert.X;
-		int32 TextureHeight_Vert = Profile->OverrideSize_Vert.Y;
-		int32 TextureWidth_Bone = Profile->OverrideSize_Bone.X;
-		int32 TextureHeight_Bone = Profile->OverrideSize_Bone.Y;
+		const int64 Texels = (int64)Profile->OverrideSize_Vert.X * Profile->OverrideSize_Vert.Y;
+		const int64 UsedTexels = (int64)NumUniqueVerts * Profile->CalcNumStoredFrames_Vert();
+		JsonReport->SetStringField(TEXT("TextureSize_Vert"), FString::Printf(TEXT("%ix%i"), Profile->OverrideSize_Vert.X, Profile->OverrideSize_Vert.Y));
+		JsonReport->SetNumberField(TEXT("WastedTexels_Vert"), Texels - UsedTexels);
+		JsonReport->SetNumberField(TEXT("WastedRatio_Vert"), Texels ? (double)(Texels - UsedTexels) / Texels : 0.0);
+		JsonReport->SetNumberField(TEXT("MaxValueOffset_Vert"), Profile->MaxValueOffset_Vert);
+		if (VertFetchMissRate >= 0.f) JsonReport->SetNumberField(TEXT("VertFetchMissRate"), VertFetchMissRate);
+	}
 
-		
-		TArray <FVector4> VertPos, VertNormal, BonePos, BoneRot;
-		GatherAndBakeAllAnimVertData(Profile, PreviewComponent, UniqueSourceIDs, VertPos, VertNormal, BonePos, BoneRot);
+	if (Profile->Anims_Bone.Num())
+	{
+		const int64 Texels = (int64)Profile->OverrideSize_Bone.X * Profile->OverrideSize_Bone.Y;
+		// Layer frames are packed side by side, their rows count as used
+		const int64 UsedTexels = ((int64)Profile->BoneNames_Generated.Num() * (Profile->CalcNumStoredFrames_Bone() + 1)) +
+			((int64)Profile->CalcTotalRows_BoneLayers() * Profile->OverrideSize_Bone.X);
+		JsonReport->SetStringField(TEXT("TextureSize_Bone"), FString::Printf(TEXT("%ix%i"), Profile->OverrideSize_Bone.X, Profile->OverrideSize_Bone.Y));
+		JsonReport->SetNumberField(TEXT("WastedTexels_Bone"), Texels - UsedTexels);
+		JsonReport->SetNumberField(TEXT("WastedRatio_Bone"), Texels ? (double)(Texels - UsedTexels) / Texels : 0.0);
+		JsonReport->SetNumberField(TEXT("MaxValuePosition_Bone"), Profile->MaxValuePosition_Bone);
+	}
 
-		FString AssetName = Profile->GetOutermost()->GetName();
-		const FString SanitizedBasePackageName = UPackageTools::SanitizePackageName(AssetName);
-		const FString PackagePath = FPackageName::GetLongPackagePath(SanitizedBasePackageName) + TEXT("/");
+	// Per LOD
+	auto SetACMRField = [&JsonReport](const TCHAR* Name, const TArray <float>& ACMR)
+	{
+		if (ACMR.Num() == 0) return;
 
-		// Vert Textures
-		if(Profile->Anims_Vert.Num())
+		TArray <TSharedPtr<FJsonValue>> JsonValues;
+		for (const float Value : ACMR)
 		{
-			TArray <FFloat16Color> Data;
-			Data.SetNumZeroed(TextureWidth_Vert * TextureHeight_Vert);
-
-
-			{
-				EncodeData_Vec(VertNormal, 2.f, false, Data); // decided on fixed 2.0 for simplicity
-
-				Profile->NormalsTexture = SetTexture2(PreviewComponent->GetWorld(), PackagePath,
-					Profile->GetName() + "_Normals", Profile->NormalsTexture,
-					TextureWidth_Vert, TextureHeight_Vert,
-					Data,
-					Profile->GetMaskedFlags() | RF_Public | RF_Standalone);
-
-				Profile->NormalsTexture->Filter = TextureFilter::TF_Nearest;
-				Profile->NormalsTexture->NeverStream = true;
-				Profile->NormalsTexture->CompressionSettings = TextureCompressionSettings::TC_VectorDisplacementmap;
-				Profile->NormalsTexture->SRGB = false;
-				Profile->NormalsTexture->Modify();
-				Profile->NormalsTexture->MarkPackageDirty();
-				Profile->NormalsTexture->PostEditChange();
-				Profile->NormalsTexture->UpdateResource();
-			}
-
-
-			{
-				EncodeData_Vec(VertPos, Profile->MaxValueOffset_Vert, true, Data);
-
-				Profile->OffsetsTexture = SetTexture2(PreviewComponent->GetWorld(), PackagePath,
-					Profile->GetName() + "_Offsets", Profile->OffsetsTexture,
-					TextureWidth_Vert, TextureHeight_Vert,
-					Data,
-					Profile->GetMaskedFlags() | RF_Public | RF_Standalone);
-
-				Profile->OffsetsTexture->Filter = TextureFilter::TF_Nearest;
-				Profile->OffsetsTexture->NeverStream = true;
-				Profile->OffsetsTexture->CompressionSettings = TextureCompressionSettings::TC_HDR;
-				Profile->OffsetsTexture->SRGB = false;
-				Profile->OffsetsTexture->Modify();
-				Profile->OffsetsTexture->MarkPackageDirty();
-				Profile->OffsetsTexture->PostEditChange();
-				Profile->OffsetsTexture->UpdateResource();
-			}
-		
+			JsonValues.Add(MakeShareable(new FJsonValueNumber(Value)));
 		}
+		JsonReport->SetArrayField(Name, JsonValues);
+	};
+	SetACMRField(TEXT("SourceACMRBefore"), MeshOrder.SourceACMRBefore);
+	SetACMRField(TEXT("SourceACMRAfter"), MeshOrder.SourceACMRAfter);
+	SetACMRField(TEXT("BuiltACMR"), MeshOrder.BuiltACMR);
+
+	const FBox Bounds = Profile->CalcAllAnimsBounds();
+	if (Bounds.IsValid)
+	{
+		JsonReport->SetStringField(TEXT("AnimBoundsMin"), Bounds.Min.ToString());
+		JsonReport->SetStringField(TEXT("AnimBoundsMax"), Bounds.Max.ToString());
+	}
 
-		// Bone Textures
-		if (Profile->Anims_Bone.Num())
-		{
-			TArray <FFloat16Color> Data;
-			Data.SetNumZeroed(TextureWidth_Bone*TextureHeight_Bone);
-
-			
-			{
-				EncodeData_Quat(true, BoneRot, Data);
+	FString JsonString;
+	TSharedRef<TJsonWriter<>> JsonWriter = TJsonWriterFactory<>::Create(&JsonString);
+	FJsonSerializer::Serialize(JsonReport.ToSharedRef(), JsonWriter);
 
-				Profile->BoneRotTexture = SetTexture2(PreviewComponent->GetWorld(), PackagePath, 
-					Profile->GetName() + "_BoneRot", Profile->BoneRotTexture,
-					TextureWidth_Bone, TextureHeight_Bone, 
-					Data,
-					Profile->GetMaskedFlags() | RF_Public | RF_Standalone);
+	const FString ReportPath = FPaths::ProjectSavedDir() / TEXT("VertexAnimToolset") / TEXT("BakeReports") /
+		Profile->GetName() + TEXT("_") + FDateTime::Now().ToString() + TEXT(".json");
+	FFileHelper::SaveStringToFile(JsonString, *ReportPath);
 
-				Profile->BoneRotTexture->Filter = TextureFilter::TF_Nearest;
-				Profile->BoneRotTexture->NeverStream = true;
-				Profile->BoneRotTexture->CompressionSettings = TextureCompressionSettings::TC_HDR;
-				Profile->BoneRotTexture->SRGB = false;
-				Profile->BoneRotTexture->Modify();
-				Profile->BoneRotTexture->MarkPackageDirty();
-				Profile->BoneRotTexture->PostEditChange();
-				Profile->BoneRotTexture->UpdateResource();
-			}
+	UE_LOG(LogVertexAnimToolset, Log, TEXT("VAT bake of %s took %.2f s, report written to %s"), *Profile->GetName(), TotalSeconds, *ReportPath);
+}
 
-			{
-				EncodeData_Vec(BonePos, Profile->MaxValuePosition_Bone, true, Data);
+FVAProfileEstimate FVATEditorUtils::EstimateProfile(const UVertexAnimProfile* Profile, const USkeletalMesh* Mesh)
+{
+	FSkeletalMeshRenderData* RenderData = Mesh ? Mesh->GetResourceForRendering() : NULL;
+	if ((Profile == NULL) || (RenderData == NULL) || (RenderData->LODRenderData.Num() == 0) || (Mesh->Skeleton == NULL))
+	{
+		return FVAProfileEstimate();
+	}
 
-				Profile->BonePosTexture = SetTexture2(PreviewComponent->GetWorld(), PackagePath,
-					Profile->GetName() + "_BonePos", Profile->BonePosTexture,
-					TextureWidth_Bone, TextureHeight_Bone, 
-					Data,//BonePos,
-					Profile->GetMaskedFlags() | RF_Public | RF_Standalone);
+	// Same unique vert merge as MapSkinVerts, the ref pose positions of LOD 0 stand in for the CPU skinned ones
+	const FPositionVertexBuffer& Positions = RenderData->LODRenderData[0].StaticVertexBuffers.PositionVertexBuffer;
 
-				Profile->BonePosTexture->Filter = TextureFilter::TF_Nearest;
-				Profile->BonePosTexture->NeverStream = true;
-				Profile->BonePosTexture->CompressionSettings = TextureCompressionSettings::TC_HDR;
-				Profile->BonePosTexture->SRGB = false;
+	TArray <int32> Verts;
+	TArray <bool> HybridMask;
+	if (Profile->HybridBake) CalcHybridVertMask(Profile, Mesh, 0, HybridMask);
+	for (int32 i = 0; i < (int32)Positions.GetNumVertices(); i++)
+	{
+		if ((HybridMask.Num() == 0) || HybridMask[i]) Verts.Add(i);
+	}
 
-				Profile->BonePosTexture->Modify();
-				Profile->BonePosTexture->MarkPackageDirty();
-				Profile->BonePosTexture->PostEditChange();
-				Profile->BonePosTexture->UpdateResource();
-			}
+	TArray <int32> UniqueID, UniqueSourceID;
+	const int32 NumUniqueVerts = FindUniqueVerts(Profile->UVMergeDuplicateVerts, Verts.Num(),
+		[&Positions, &Verts](int32 i) { return Positions.VertexPosition(Verts[i]); }, UniqueID, UniqueSourceID);
 
+	const FReferenceSkeleton& GlobalRefSkeleton = Mesh->Skeleton->GetReferenceSkeleton();
+	int32 NumBones = GlobalRefSkeleton.GetNum();
+	if (Profile->ActiveBonesOnly)
+	{
+		TArray <int32> ColumnBones;
+		for (int32 LOD = 0; LOD < RenderData->LODRenderData.Num(); LOD++)
+		{
+			AddActiveBones(Mesh, LOD, GlobalRefSkeleton, ColumnBones);
 		}
-
+		AddMaskBones(Profile, GlobalRefSkeleton, ColumnBones);
+		NumBones = ColumnBones.Num();
 	}
+
+	FVAProfileEstimate Out = Profile->CalcEstimate(NumUniqueVerts, NumBones);
+	Out.NumMeshUVChannels = RenderData->LODRenderData[0].StaticVertexBuffers.StaticMeshVertexBuffer.GetNumTexCoords();
+
+	return Out;
 }
 
 void FVATEditorUtils::UVChannelsToSkeletalMesh(USkeletalMesh* Skel, const int32 LODIndex, const int32 UVChannelStart, TArray<TArray<FVector2D>>& UVChannels)
@@ -1301,5 +3768,383 @@ void FVATEditorUtils::ClosestUVPivotAssign(
 }
 
 
+//--------------------------------------
+// Bake benchmark
+
+// Names of the timed stages, Skinning is the emulated CPU skinning that feeds the gather
+static const TCHAR* BakeBenchStageNames[] =
+{
+	TEXT("MapSkinVerts"),
+	TEXT("MapActiveBones"),
+	TEXT("MapLODVerts"),
+	TEXT("Skinning"),
+	TEXT("Gather_Vert"),
+	TEXT("Gather_Bone"),
+	TEXT("EncodeData_Vec"),
+	TEXT("EncodeData_Quat"),
+	TEXT("SetTexture2"),
+};
+static constexpr int32 NumBakeBenchStages = UE_ARRAY_COUNT(BakeBenchStageNames);
+
+struct FVATBakeBenchResult
+{
+	int32 NumVerts = 0;
+	int32 NumBones = 0;
+	int32 NumLODs = 0;
+	int32 NumFrames = 0;
+	FIntPoint TextureSize_Vert = FIntPoint::ZeroValue;
+	FIntPoint TextureSize_Bone = FIntPoint::ZeroValue;
+	double Seconds[NumBakeBenchStages] = {};
+};
+
+// Cylinder of rings along Z skinned to a chain of bones, the last vert of every ring is a seam duplicate of the first
+static void MakeBakeBenchMesh(
+	const int32 NumVerts, const int32 NumBones,
+	FReferenceSkeleton& OutRefSkeleton, TArray <FTransform>& OutRefPoseCS,
+	TArray <FFinalSkinVertex>& OutVerts, TArray <FIntPoint>& OutInfluences, TArray <float>& OutWeights)
+{
+	const int32 RingVerts = 33;
+	const float RingStep = 2.f;
+	const float Radius = 20.f;
+	const int32 NumRings = FMath::DivideAndRoundUp(NumVerts, RingVerts);
+	const float BoneLength = (NumRings * RingStep) / NumBones;
+
+	{
+		FReferenceSkeletonModifier Modifier(OutRefSkeleton, nullptr);
+		for (int32 B = 0; B < NumBones; B++)
+		{
+			const FName BoneName = FName(*FString::Printf(TEXT("Bone_%03d"), B));
+			Modifier.Add(FMeshBoneInfo(BoneName, BoneName.ToString(), B - 1), FTransform(FVector(0, 0, B == 0 ? 0.f : BoneLength)));
+		}
+	}
+
+	OutRefPoseCS.SetNum(NumBones);
+	for (int32 B = 0; B < NumBones; B++)
+	{
+		OutRefPoseCS[B] = FAnimationRuntime::GetComponentSpaceTransformRefPose(OutRefSkeleton, B);
+	}
+
+	OutVerts.SetNumZeroed(NumVerts);
+	OutInfluences.SetNum(NumVerts);
+	OutWeights.SetNum(NumVerts);
+
+	for (int32 i = 0; i < NumVerts; i++)
+	{
+		const int32 Ring = i / RingVerts;
+		const int32 InRing = i % RingVerts;
+		const float Angle = (2.f * PI * (InRing % (RingVerts - 1))) / (RingVerts - 1);
+		const FVector Normal = FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f);
+
+		OutVerts[i].Position = (Normal * Radius) + FVector(0, 0, Ring * RingStep);
+		OutVerts[i].TangentZ = Normal;
+		OutVerts[i].U = (float)InRing / (RingVerts - 1);
+		OutVerts[i].V = (float)Ring / NumRings;
+
+		const float BoneCoord = FMath::Clamp(OutVerts[i].Position.Z / BoneLength, 0.f, (float)(NumBones - 1));
+		const int32 Bone0 = FMath::FloorToInt(BoneCoord);
+		OutInfluences[i] = FIntPoint(Bone0, FMath::Min(Bone0 + 1, NumBones - 1));
+		OutWeights[i] = 1.f - (BoneCoord - Bone0);
+	}
+}
+
+// Swaying pose of the bone chain for a frame, returned as ref pose to animated pose matrices like CacheRefToLocalMatrices
+static void MakeBakeBenchPose(
+	const FReferenceSkeleton& RefSkeleton, const TArray <FTransform>& RefPoseCS,
+	const int32 Frame, const int32 NumFrames, TArray <FMatrix>& OutRefToLocal)
+{
+	const int32 NumBones = RefSkeleton.GetNum();
+	const TArray <FTransform>& RefPose = RefSkeleton.GetRefBonePose();
+
+	TArray <FTransform> PoseCS;
+	PoseCS.SetNum(NumBones);
+	OutRefToLocal.SetNum(NumBones);
+
+	const float Phase = (2.f * PI * Frame) / NumFrames;
+	for (int32 B = 0; B < NumBones; B++)
+	{
+		FTransform Local = RefPose[B];
+		Local.SetRotation(FQuat(FVector(1, 0, 0), 0.1f * FMath::Sin(Phase + (B * 0.3f))));
+
+		const int32 Parent = RefSkeleton.GetParentIndex(B);
+		PoseCS[B] = (Parent == INDEX_NONE) ? Local : Local * PoseCS[Parent];
+		OutRefToLocal[B] = (RefPoseCS[B].Inverse() * PoseCS[B]).ToMatrixWithScale();
+	}
+}
+
+static void BakeBenchSkin(
+	const TArray <FFinalSkinVertex>& RefVerts, const TArray <FIntPoint>& Influences, const TArray <float>& Weights,
+	const TArray <FMatrix>& RefToLocal, TArray <FFinalSkinVertex>& OutVerts)
+{
+	OutVerts.SetNumUninitialized(RefVerts.Num());
+
+	for (int32 i = 0; i < RefVerts.Num(); i++)
+	{
+		const FMatrix& M0 = RefToLocal[Influences[i].X];
+		const FMatrix& M1 = RefToLocal[Influences[i].Y];
+		const float W0 = Weights[i];
+		const float W1 = 1.f - W0;
+
+		const FVector Normal = RefVerts[i].TangentZ.ToFVector();
+
+		OutVerts[i] = RefVerts[i];
+		OutVerts[i].Position = (M0.TransformPosition(RefVerts[i].Position) * W0) + (M1.TransformPosition(RefVerts[i].Position) * W1);
+		OutVerts[i].TangentZ = ((M0.TransformVector(Normal) * W0) + (M1.TransformVector(Normal) * W1)).GetSafeNormal();
+	}
+}
+
+// Lower LODs keep every 2^LOD th vert, enough to time the closest vert search
+static void MakeBakeBenchLODs(const TArray <FFinalSkinVertex>& LOD0Verts, const int32 NumLODs, TArray <TArray <FFinalSkinVertex>>& OutLODVerts)
+{
+	OutLODVerts.SetNum(NumLODs);
+	OutLODVerts[0] = LOD0Verts;
+
+	for (int32 L = 1; L < NumLODs; L++)
+	{
+		const int32 Stride = 1 << L;
+		OutLODVerts[L].Reset(LOD0Verts.Num() / Stride + 1);
+		for (int32 i = 0; i < LOD0Verts.Num(); i += Stride)
+		{
+			OutLODVerts[L].Add(LOD0Verts[i]);
+		}
+	}
+}
+
+static UTexture2D* BakeBenchTexture(const FIntPoint Size, const TArray <FFloat16Color>& Data)
+{
+	UTexture2D* Placeholder = NewObject<UTexture2D>(GetTransientPackage(),
+		MakeUniqueObjectName(GetTransientPackage(), UTexture2D::StaticClass(), TEXT("VATBakeBenchmark")), RF_Transient);
+
+	return SetTexture2(NULL, FString(), FString(), Placeholder, Size.X, Size.Y, Data, RF_Transient);
+}
+
+static bool RunBakeBenchCase(
+	const int32 NumVerts, const int32 NumBones, const int32 NumLODs, const int32 NumFrames, FVATBakeBenchResult& OutResult)
+{
+	OutResult.NumVerts = NumVerts;
+	OutResult.NumBones = NumBones;
+	OutResult.NumLODs = NumLODs;
+	OutResult.NumFrames = NumFrames;
+
+	FReferenceSkeleton RefSkeleton;
+	TArray <FTransform> RefPoseCS;
+	TArray <FFinalSkinVertex> RefPoseVerts;
+	TArray <FIntPoint> Influences;
+	TArray <float> Weights;
+	MakeBakeBenchMesh(NumVerts, NumBones, RefSkeleton, RefPoseCS, RefPoseVerts, Influences, Weights);
+
+	TArray <TArray <FFinalSkinVertex>> LODVerts;
+	MakeBakeBenchLODs(RefPoseVerts, NumLODs, LODVerts);
+
+	UVertexAnimProfile* Profile = NewObject<UVertexAnimProfile>(GetTransientPackage(), NAME_None, RF_Transient);
+	Profile->AutoSize = true;
+	Profile->UVMergeDuplicateVerts = true;
+	Profile->Anims_Vert.AddDefaulted();
+	Profile->Anims_Vert[0].NumFrames = NumFrames;
+	Profile->Anims_Bone.AddDefaulted();
+	Profile->Anims_Bone[0].NumFrames = NumFrames;
+
+	double* Seconds = OutResult.Seconds;
+	double StartTime = FPlatformTime::Seconds();
+	auto EndStage = [&StartTime, Seconds](const int32 Stage)
+	{
+		const double Now = FPlatformTime::Seconds();
+		Seconds[Stage] += Now - StartTime;
+		StartTime = Now;
+	};
+
+	// Layout
+	TArray <int32> UniqueSourceIDs;
+	TArray <FVector2D> GridUVs_Vert;
+	StartTime = FPlatformTime::Seconds();
+	MapSkinVerts(Profile, RefPoseVerts, UniqueSourceIDs, GridUVs_Vert);
+	EndStage(0);
+
+	TArray <FVector2D> GridUVs_Bone;
+	MapActiveBones(Profile, NumBones, GridUVs_Bone);
+	EndStage(1);
+
+	for (int32 L = 1; L < NumLODs; L++)
+	{
+		TArray <FVector2D> LODGridUVs_Vert;
+		MapLODVertsToGrid(LODVerts[L], RefPoseVerts, UniqueSourceIDs, GridUVs_Vert, LODGridUVs_Vert);
+	}
+	EndStage(2);
+
+	OutResult.TextureSize_Vert = Profile->OverrideSize_Vert;
+	OutResult.TextureSize_Bone = Profile->OverrideSize_Bone;
+
+	if ((Profile->OverrideSize_Vert.GetMax() > 4096) || (Profile->OverrideSize_Bone.GetMax() > 4096)) return false;
+
+	// Gather
+	const int32 PerFrameArrayNum_Vert = Profile->OverrideSize_Vert.X * Profile->RowsPerFrame_Vert;
+	const int32 PerFrameArrayNum_Bone = Profile->OverrideSize_Bone.X;
+
+	TArray <FVector4> GridVertPos, GridVertNormal, GridBonePos, GridBoneRot;
+	TArray <FVector4> ZeroedBonePos, ZeroedBoneRot;
+	ZeroedBonePos.SetNumZeroed(PerFrameArrayNum_Bone);
+	ZeroedBoneRot.SetNumZeroed(PerFrameArrayNum_Bone);
+
+	float MaxValueOffset = 0.f;
+	float MaxValuePosBone = 0.f;
+	TArray <FMatrix> RefToLocal;
+	TArray <FFinalSkinVertex> FinalVerts;
+	TArray <int32> MeshToGlobalBone;
+
+	TArray <FVector> RefPosePositions, RefPoseNormals;
+
+	StartTime = FPlatformTime::Seconds();
+	GatherUniqueVerts(RefPoseVerts, UniqueSourceIDs, RefPosePositions, RefPoseNormals);
+	GridVertPos.SetNumZeroed(PerFrameArrayNum_Vert * NumFrames);
+	GridVertNormal.SetNumZeroed(GridVertPos.Num());
+	EndStage(4);
+
+	MapMeshToGlobalBones(RefSkeleton, RefSkeleton, MeshToGlobalBone);
+	GridBonePos.Reserve(PerFrameArrayNum_Bone * NumFrames);
+	GridBoneRot.Reserve(PerFrameArrayNum_Bone * NumFrames);
+	EndStage(5);
+
+	for (int32 j = 0; j < NumFrames; j++)
+	{
+		MakeBakeBenchPose(RefSkeleton, RefPoseCS, j, NumFrames, RefToLocal);
+		BakeBenchSkin(RefPoseVerts, Influences, Weights, RefToLocal, FinalVerts);
+		EndStage(3);
+
+		StoreFrameVertDeltas(FinalVerts, RefPosePositions, RefPoseNormals, UniqueSourceIDs,
+			TArrayView <FVector4>(GridVertPos.GetData() + (j * PerFrameArrayNum_Vert), PerFrameArrayNum_Vert),
+			TArrayView <FVector4>(GridVertNormal.GetData() + (j * PerFrameArrayNum_Vert), PerFrameArrayNum_Vert),
+			MaxValueOffset);
+		CalcSkinVertsBounds(FinalVerts);
+		EndStage(4);
+
+		StoreFrameBoneTransforms(RefToLocal, MeshToGlobalBone, ZeroedBonePos, ZeroedBoneRot, MaxValuePosBone);
+		GridBonePos.Append(ZeroedBonePos);
+		GridBoneRot.Append(ZeroedBoneRot);
+		EndStage(5);
+	}
+
+	// Encode
+	TArray <FFloat16Color> Data_Vert, Data_Bone;
+	Data_Vert.SetNumZeroed(Profile->OverrideSize_Vert.X * Profile->OverrideSize_Vert.Y);
+	Data_Bone.SetNumZeroed(Profile->OverrideSize_Bone.X * Profile->OverrideSize_Bone.Y);
+
+	StartTime = FPlatformTime::Seconds();
+	EncodeData_Vec(GridVertNormal, 2.f, false, Data_Vert);
+	FMemory::Memzero(Data_Vert.GetData(), Data_Vert.Num() * sizeof(FFloat16Color));
+	EncodeData_Vec(GridVertPos, MaxValueOffset, true, Data_Vert);
+	EncodeData_Vec(GridBonePos, MaxValuePosBone, true, Data_Bone);
+	EndStage(6);
+
+	FMemory::Memzero(Data_Bone.GetData(), Data_Bone.Num() * sizeof(FFloat16Color));
+	StartTime = FPlatformTime::Seconds();
+	EncodeData_Quat(true, GridBoneRot, Data_Bone);
+	EndStage(7);
+
+	BakeBenchTexture(Profile->OverrideSize_Vert, Data_Vert);
+	BakeBenchTexture(Profile->OverrideSize_Bone, Data_Bone);
+	EndStage(8);
+
+	return true;
+}
+
+void FVATEditorUtils::RunBakeBenchmark(const bool bQuick, FOutputDevice& Ar)
+{
+	const TArray <int32> VertCounts = bQuick ? TArray <int32>({ 1000, 5000 }) : TArray <int32>({ 1000, 5000, 20000 });
+	const TArray <int32> BoneCounts = bQuick ? TArray <int32>({ 32 }) : TArray <int32>({ 32, 128 });
+	const TArray <int32> LODCounts = bQuick ? TArray <int32>({ 1 }) : TArray <int32>({ 1, 3 });
+	const TArray <int32> FrameCounts = bQuick ? TArray <int32>({ 30 }) : TArray <int32>({ 30, 120 });
+
+	const int32 NumCases = VertCounts.Num() * BoneCounts.Num() * LODCounts.Num() * FrameCounts.Num();
+	FScopedSlowTask SlowTask((float)NumCases, LOCTEXT("BakeBenchmark", "Running VAT bake benchmark"));
+	SlowTask.MakeDialog();
+
+	TArray <FVATBakeBenchResult> Results;
+
+	for (const int32 NumVerts : VertCounts)
+	for (const int32 NumBones : BoneCounts)
+	for (const int32 NumLODs : LODCounts)
+	for (const int32 NumFrames : FrameCounts)
+	{
+		SlowTask.EnterProgressFrame(1.f);
+
+		FVATBakeBenchResult Result;
+		if (RunBakeBenchCase(NumVerts, NumBones, NumLODs, NumFrames, Result))
+		{
+			Results.Add(Result);
+		}
+		else
+		{
+			Ar.Logf(TEXT("VAT bake benchmark: skipped %i verts, %i frames, texture size over 4096"), NumVerts, NumFrames);
+		}
+
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	// Report, throughput is in verts x frames per second for every stage so the curves of all stages can be compared
+	const TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("VertexAnimToolset"));
+	const FString PluginVersion = Plugin.IsValid() ? Plugin->GetDescriptor().VersionName : FString();
+
+	FString CSV = TEXT("Verts,Bones,LODs,Frames,TextureSize_Vert,TextureSize_Bone,Stage,Seconds,VertFramesPerSecond\n");
+	TArray <TSharedPtr<FJsonValue>> JsonCases;
+
+	for (const FVATBakeBenchResult& Result : Results)
+	{
+		const double VertFrames = (double)Result.NumVerts * Result.NumFrames;
+
+		TSharedPtr<FJsonObject> JsonCase = MakeShareable(new FJsonObject);
+		JsonCase->SetNumberField(TEXT("Verts"), Result.NumVerts);
+		JsonCase->SetNumberField(TEXT("Bones"), Result.NumBones);
+		JsonCase->SetNumberField(TEXT("LODs"), Result.NumLODs);
+		JsonCase->SetNumberField(TEXT("Frames"), Result.NumFrames);
+		JsonCase->SetStringField(TEXT("TextureSize_Vert"), FString::Printf(TEXT("%ix%i"), Result.TextureSize_Vert.X, Result.TextureSize_Vert.Y));
+		JsonCase->SetStringField(TEXT("TextureSize_Bone"), FString::Printf(TEXT("%ix%i"), Result.TextureSize_Bone.X, Result.TextureSize_Bone.Y));
+
+		TSharedPtr<FJsonObject> JsonStages = MakeShareable(new FJsonObject);
+		double TotalSeconds = 0.0;
+
+		for (int32 S = 0; S < NumBakeBenchStages; S++)
+		{
+			const double Seconds = Result.Seconds[S];
+			const double Throughput = Seconds > 0.0 ? VertFrames / Seconds : 0.0;
+			TotalSeconds += Seconds;
+
+			CSV += FString::Printf(TEXT("%i,%i,%i,%i,%ix%i,%ix%i,%s,%f,%f\n"),
+				Result.NumVerts, Result.NumBones, Result.NumLODs, Result.NumFrames,
+				Result.TextureSize_Vert.X, Result.TextureSize_Vert.Y, Result.TextureSize_Bone.X, Result.TextureSize_Bone.Y,
+				BakeBenchStageNames[S], Seconds, Throughput);
+
+			TSharedPtr<FJsonObject> JsonStage = MakeShareable(new FJsonObject);
+			JsonStage->SetNumberField(TEXT("Seconds"), Seconds);
+			JsonStage->SetNumberField(TEXT("VertFramesPerSecond"), Throughput);
+			JsonStages->SetObjectField(BakeBenchStageNames[S], JsonStage);
+		}
+
+		JsonCase->SetObjectField(TEXT("Stages"), JsonStages);
+		JsonCase->SetNumberField(TEXT("TotalSeconds"), TotalSeconds);
+		JsonCase->SetNumberField(TEXT("VertFramesPerSecond"), TotalSeconds > 0.0 ? VertFrames / TotalSeconds : 0.0);
+		JsonCases.Add(MakeShareable(new FJsonValueObject(JsonCase)));
+
+		Ar.Logf(TEXT("VAT bake benchmark: %i verts, %i bones, %i LODs, %i frames: %.3f s, %.0f verts x frames / s"),
+			Result.NumVerts, Result.NumBones, Result.NumLODs, Result.NumFrames, TotalSeconds, TotalSeconds > 0.0 ? VertFrames / TotalSeconds : 0.0);
+	}
+
+	TSharedPtr<FJsonObject> JsonReport = MakeShareable(new FJsonObject);
+	JsonReport->SetStringField(TEXT("EngineVersion"), FEngineVersion::Current().ToString());
+	JsonReport->SetStringField(TEXT("PluginVersion"), PluginVersion);
+	JsonReport->SetBoolField(TEXT("Quick"), bQuick);
+	JsonReport->SetArrayField(TEXT("Cases"), JsonCases);
+
+	FString JsonString;
+	TSharedRef<TJsonWriter<>> JsonWriter = TJsonWriterFactory<>::Create(&JsonString);
+	FJsonSerializer::Serialize(JsonReport.ToSharedRef(), JsonWriter);
+
+	const FString ReportDir = FPaths::ProjectSavedDir() / TEXT("VertexAnimToolset");
+	const FString ReportName = TEXT("BakeBenchmark_") + FDateTime::Now().ToString();
+	FFileHelper::SaveStringToFile(CSV, *(ReportDir / ReportName + TEXT(".csv")));
+	FFileHelper::SaveStringToFile(JsonString, *(ReportDir / ReportName + TEXT(".json")));
+
+	Ar.Logf(TEXT("VAT bake benchmark: report written to %s"), *(ReportDir / ReportName));
+}
+
+
 #undef LOCTEXT_NAMESPACE
 
@@ -0,0 +1,129 @@
+// Copyright 2019-2021 Rexocrates. All Rights Reserved.
+
+#include "VertexAnimProfileDetails.h"
+
+#include "VertexAnimProfile.h"
+#include "VATEditorUtils.h"
+
+#include "Engine/SkeletalMesh.h"
+#include "DetailLayoutBuilder.h"
+#include "DetailCategoryBuilder.h"
+#include "DetailWidgetRow.h"
+#include "Widgets/Text/STextBlock.h"
+
+#define LOCTEXT_NAMESPACE "VertexAnimProfileDetails"
+
+TSharedRef<IDetailCustomization> FVertexAnimProfileDetails::MakeInstance()
+{
+	return MakeShareable(new FVertexAnimProfileDetails);
+}
+
+void FVertexAnimProfileDetails::CustomizeDetails(IDetailLayoutBuilder& DetailBuilder)
+{
+	TArray<TWeakObjectPtr<UObject>> Objects;
+	DetailBuilder.GetObjectsBeingCustomized(Objects);
+	if (Objects.Num() != 1) return;
+
+	Profile = Cast<UVertexAnimProfile>(Objects[0].Get());
+
+	IDetailCategoryBuilder& Category = DetailBuilder.EditCategory("Estimate");
+	Category.AddCustomRow(LOCTEXT("EstimateRow", "Estimate"))
+		.WholeRowContent()
+		[
+			SNew(STextBlock)
+			.Font(IDetailLayoutBuilder::GetDetailFont())
+			.AutoWrapText(true)
+			.Text_Raw(this, &FVertexAnimProfileDetails::GetEstimateText)
+			.ColorAndOpacity_Raw(this, &FVertexAnimProfileDetails::GetEstimateColor)
+		];
+}
+
+const FVAProfileEstimate* FVertexAnimProfileDetails::UpdateEstimate() const
+{
+	UVertexAnimProfile* ProfilePtr = Profile.Get();
+	if ((ProfilePtr == NULL) || (ProfilePtr->EstimateMesh == NULL))
+	{
+		CachedEstimate.Reset();
+		return NULL;
+	}
+
+	if (!CachedEstimate.IsValid() || (CachedMesh.Get() != ProfilePtr->EstimateMesh) || (bCachedMerge != ProfilePtr->UVMergeDuplicateVerts))
+	{
+		CachedEstimate = MakeShareable(new FVAProfileEstimate(FVATEditorUtils::EstimateProfile(ProfilePtr, ProfilePtr->EstimateMesh)));
+		CachedMesh = ProfilePtr->EstimateMesh;
+		bCachedMerge = ProfilePtr->UVMergeDuplicateVerts;
+	}
+	else
+	{
+		// Only the counts are kept, the layout follows the current anims and size settings
+		const FVAProfileEstimate Counts = *CachedEstimate;
+		*CachedEstimate = ProfilePtr->CalcEstimate(Counts.NumUniqueVerts, Counts.NumBones);
+		CachedEstimate->NumMeshUVChannels = Counts.NumMeshUVChannels;
+	}
+
+	return CachedEstimate.Get();
+}
+
+FText FVertexAnimProfileDetails::GetEstimateText() const
+{
+	const FVAProfileEstimate* Estimate = UpdateEstimate();
+	if (Estimate == NULL)
+	{
+		return LOCTEXT("NoEstimateMesh", "Set Estimate Mesh to see the texture sizes and costs of this profile before baking.");
+	}
+
+	FNumberFormattingOptions MBFormat;
+	MBFormat.MaximumFractionalDigits = 2;
+	const auto ToMB = [&MBFormat](const int64 Bytes) { return FText::AsNumber(Bytes / (1024.0 * 1024.0), &MBFormat); };
+
+	FTextBuilder Builder;
+	Builder.AppendLineFormat(LOCTEXT("EstimateCounts", "Unique Verts: {0}   Skeleton Bones: {1}"),
+		FText::AsNumber(Estimate->NumUniqueVerts), FText::AsNumber(Estimate->NumBones));
+
+	if (Estimate->TextureSize_Vert.X > 0)
+	{
+		Builder.AppendLineFormat(LOCTEXT("EstimateVert", "Vert Textures: 2 x {0}x{1} RGBA16F, {2} MB each, {3} wasted texels, required height {4}, {5} fetches per vertex"),
+			FText::AsNumber(Estimate->TextureSize_Vert.X), FText::AsNumber(Estimate->TextureSize_Vert.Y), ToMB(Estimate->TextureBytes_Vert),
+			FText::AsNumber(Estimate->WastedTexels_Vert), FText::AsNumber(Estimate->RequiredHeight_Vert), FText::AsNumber(Estimate->FetchesPerVertex_Vert));
+	}
+
+	if (Estimate->TextureSize_Bone.X > 0)
+	{
+		Builder.AppendLineFormat(LOCTEXT("EstimateBone", "Bone Textures: 2 x {0}x{1} RGBA16F, {2} MB each, {3} wasted texels, required height {4}, {5} fetches per vertex"),
+			FText::AsNumber(Estimate->TextureSize_Bone.X), FText::AsNumber(Estimate->TextureSize_Bone.Y), ToMB(Estimate->TextureBytes_Bone),
+			FText::AsNumber(Estimate->WastedTexels_Bone), FText::AsNumber(Estimate->RequiredHeight_Bone), FText::AsNumber(Estimate->FetchesPerVertex_Bone));
+	}
+
+	Builder.AppendLineFormat(LOCTEXT("EstimateTotal", "Total VRAM: {0} MB   UV Channels: {1} + {2} VAT{3}"),
+		ToMB(Estimate->TotalBytes), FText::AsNumber(Estimate->NumMeshUVChannels), FText::AsNumber(Estimate->NumUVChannels),
+		Estimate->bUsesVertexColors ? LOCTEXT("EstimateColors", ", Vertex Colors") : FText::GetEmpty());
+
+	if (Estimate->bUpperBound)
+	{
+		Builder.AppendLine(LOCTEXT("EstimateUpperBound", "Upper bound: Sparse Vert Anim / Deduplicate Frames compact the textures when baking, the baked sizes can be smaller"));
+	}
+
+	if (!Estimate->bWithinSizeLimit)
+	{
+		Builder.AppendLine(Estimate->bUpperBound ?
+			LOCTEXT("EstimateTooMuchUpperBound", "Required texture size exceeds UE texture resolution limit (4096) before compaction, the bake fails unless it compacts enough") :
+			LOCTEXT("EstimateTooMuch", "Required texture size exceeds UE texture resolution limit (4096), the bake will fail"));
+	}
+	else if (!Estimate->bFitsHeight)
+	{
+		Builder.AppendLine(Estimate->bUpperBound ?
+			LOCTEXT("EstimateRequiresMoreHeightUpperBound", "Profile Requires More Texture Height before compaction, the bake fails unless it compacts enough") :
+			LOCTEXT("EstimateRequiresMoreHeight", "Profile Requires More Texture Height, the bake will fail"));
+	}
+
+	return Builder.ToText();
+}
+
+FSlateColor FVertexAnimProfileDetails::GetEstimateColor() const
+{
+	const FVAProfileEstimate* Estimate = CachedEstimate.Get();
+	const bool bFails = Estimate && (!Estimate->bWithinSizeLimit || !Estimate->bFitsHeight);
+	return bFails ? FSlateColor(FLinearColor::Red) : FSlateColor::UseForeground();
+}
+
+#undef LOCTEXT_NAMESPACE
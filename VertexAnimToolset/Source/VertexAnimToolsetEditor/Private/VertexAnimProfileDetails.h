@@ -0,0 +1,32 @@
+// Copyright 2019-2021 Rexocrates. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IDetailCustomization.h"
+
+class UVertexAnimProfile;
+class USkeletalMesh;
+struct FVAProfileEstimate;
+
+// Profile details with a live pre-bake estimate of the texture sizes and costs for EstimateMesh
+class FVertexAnimProfileDetails : public IDetailCustomization
+{
+public:
+	static TSharedRef<IDetailCustomization> MakeInstance();
+
+	virtual void CustomizeDetails(IDetailLayoutBuilder& DetailBuilder) override;
+
+private:
+	FText GetEstimateText() const;
+	FSlateColor GetEstimateColor() const;
+
+	// The unique vert merge is the only costly part, it is redone when the mesh or the merge setting change
+	const FVAProfileEstimate* UpdateEstimate() const;
+
+	TWeakObjectPtr<UVertexAnimProfile> Profile;
+
+	mutable TSharedPtr<FVAProfileEstimate> CachedEstimate;
+	mutable TWeakObjectPtr<USkeletalMesh> CachedMesh;
+	mutable bool bCachedMerge = false;
+};
@@ -51,6 +51,7 @@
 
 #include "Misc/FeedbackContext.h"
 #include "Misc/MessageDialog.h"
+#include "HAL/IConsoleManager.h"
 
 #include "IPersonaPreviewScene.h"
 #include "AssetViewerSettings.h"
@@ -74,6 +75,8 @@
 #include "PackageTools.h"
 
 #include "VATEditorUtils.h"
+#include "VertexAnimProfileDetails.h"
+#include "PropertyEditorModule.h"
 
 #define LOCTEXT_NAMESPACE "FVertexAnimToolsetEditorModule"
 
@@ -99,6 +102,20 @@ void FVertexAnimToolsetEditorModule::StartupModule()
 			}
 		}
 	});
+
+	FPropertyEditorModule& PropertyModule = FModuleManager::LoadModuleChecked<FPropertyEditorModule>("PropertyEditor");
+	PropertyModule.RegisterCustomClassLayout(UVertexAnimProfile::StaticClass()->GetFName(),
+		FOnGetDetailCustomizationInstance::CreateStatic(&FVertexAnimProfileDetails::MakeInstance));
+
+	BakeBenchmarkCommand = IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("VAT.BenchmarkBake"),
+		TEXT("Times the VAT bake stages on synthetic skinned meshes and writes a report to Saved/VertexAnimToolset. Pass quick for a smaller sweep."),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const bool bQuick = Args.Num() && (Args[0] == TEXT("quick"));
+		FVATEditorUtils::RunBakeBenchmark(bQuick, *GLog);
+	}),
+		ECVF_Default);
 }
 
 void FVertexAnimToolsetEditorModule::ShutdownModule()
@@ -109,7 +126,19 @@ void FVertexAnimToolsetEditorModule::ShutdownModule()
 
 	// This is not causing the stuck on exiting Unreal??
 	RemoveSkeletalMeshEditorToolbarExtender();
+	FVATEditorUtils::CancelBake();
 	FModuleManager::Get().OnModulesChanged().Remove(ModuleLoadedDelegateHandle);
+
+	if (FPropertyEditorModule* PropertyModule = FModuleManager::GetModulePtr<FPropertyEditorModule>("PropertyEditor"))
+	{
+		PropertyModule->UnregisterCustomClassLayout(UVertexAnimProfile::StaticClass()->GetFName());
+	}
+
+	if (BakeBenchmarkCommand)
+	{
+		IConsoleManager::Get().UnregisterConsoleObject(BakeBenchmarkCommand);
+		BakeBenchmarkCommand = NULL;
+	}
 }
 
 TSharedRef<FExtender> FVertexAnimToolsetEditorModule::GetAnimationEditorToolbarExtender(const TSharedRef<FUICommandList> CommandList, TSharedRef<IAnimationEditor> InAnimationEditor)
@@ -140,7 +169,7 @@ void FVertexAnimToolsetEditorModule::HandleAddSkeletalMeshActionExtenderToToolba
 	})),
 		NAME_None,
 		LOCTEXT("BakeAnim", "Bake Anim"),
-		LOCTEXT("BakeAnimToTextureTooltip", "Bake animation frames to textures"),
+		LOCTEXT("BakeAnimToTextureTooltip", "Bake animation frames to textures. The bake runs while the editor stays usable, it can be cancelled from its notification"),
 		FSlateIcon("EditorStyle", "Persona.TogglePreviewAsset", "Persona.TogglePreviewAsset.Small")
 		);
 }
@@ -68,6 +68,7 @@
 #include "Materials/MaterialInstanceDynamic.h"
 
 #include "RawMesh.h"
+#include "IMeshUtilities.h"
 #include "StaticMeshResources.h"
 #include "MeshBuild.h"
 
@@ -411,7 +412,242 @@ static void SkinnedMeshToRawMeshes(USkinnedMeshComponent* InSkinnedMeshComponent
 }
 
 
-UStaticMesh* FVertexAnimUtils::ConvertMeshesToStaticMesh(const TArray<UMeshComponent*>& InMeshComponents, const FTransform& InRootTransform, const FString& InPackageName)
+// Writes the VAT channels into the wedges of the raw meshes, the UVs and colors are indexed by the wedge vertex
+static void VATChannelsToRawMeshes(const FVATStaticMeshChannels& InVATChannels, TArray<FRawMeshTracker>& RawMeshTrackers, TArray<FRawMesh>& RawMeshes)
+{
+	for (int32 RawMeshIndex = 0; RawMeshIndex < RawMeshes.Num(); RawMeshIndex++)
+	{
+		FRawMesh& RawMesh = RawMeshes[RawMeshIndex];
+		const int32 NumWedges = RawMesh.WedgeIndices.Num();
+
+		for (const FVATStaticMeshChannels::FUVChannel& UVChannel : InVATChannels.UVChannels)
+		{
+			if ((UVChannel.Channel >= MAX_MESH_TEXTURE_COORDS) || !UVChannel.UVs->IsValidIndex(RawMeshIndex)) continue;
+
+			const TArray<FVector2D>& LODUVs = (*UVChannel.UVs)[RawMeshIndex];
+			TArray<FVector2D>& WedgeUVs = RawMesh.WedgeTexCoords[UVChannel.Channel];
+			WedgeUVs.SetNumUninitialized(NumWedges);
+
+			for (int32 WedgeIndex = 0; WedgeIndex < NumWedges; WedgeIndex++)
+			{
+				WedgeUVs[WedgeIndex] = LODUVs[RawMesh.WedgeIndices[WedgeIndex]];
+			}
+
+			RawMeshTrackers[RawMeshIndex].bValidTexCoords[UVChannel.Channel] = true;
+		}
+
+		if (InVATChannels.Colors && InVATChannels.Colors->IsValidIndex(RawMeshIndex))
+		{
+			const TArray<FColor>& LODColors = (*InVATChannels.Colors)[RawMeshIndex];
+			RawMesh.WedgeColors.SetNumUninitialized(NumWedges);
+
+			for (int32 WedgeIndex = 0; WedgeIndex < NumWedges; WedgeIndex++)
+			{
+				RawMesh.WedgeColors[WedgeIndex] = LODColors[RawMesh.WedgeIndices[WedgeIndex]];
+			}
+
+			RawMeshTrackers[RawMeshIndex].bValidColors = true;
+		}
+	}
+}
+
+// Post transform cache misses per triangle on a FIFO cache of 32 verts
+static float CalcACMR(const TArray<uint32>& Indices)
+{
+	const int32 CacheSize = 32;
+	if (Indices.Num() < 3) return 0.f;
+
+	TArray<uint32, TInlineAllocator<CacheSize>> Cache;
+	int32 Misses = 0;
+
+	for (const uint32 Index : Indices)
+	{
+		if (Cache.Contains(Index)) continue;
+
+		Misses++;
+		if (Cache.Num() == CacheSize) Cache.RemoveAt(0, 1, false);
+		Cache.Add(Index);
+	}
+
+	return (float)Misses / (Indices.Num() / 3);
+}
+
+// Reorders per face or per wedge data of a raw mesh, arrays not holding Stride entries per face (unused channels) are left alone
+template <typename T>
+static void PermuteRawMeshArray(TArray<T>& Array, const TArray<int32>& NewFaceOrder, const int32 Stride)
+{
+	if (Array.Num() != NewFaceOrder.Num() * Stride) return;
+
+	TArray<T> Permuted;
+	Permuted.Reserve(Array.Num());
+	for (const int32 Face : NewFaceOrder)
+	{
+		for (int32 k = 0; k < Stride; k++)
+		{
+			Permuted.Add(Array[(Face * Stride) + k]);
+		}
+	}
+
+	Array = MoveTemp(Permuted);
+}
+
+// Splits faces in draw order into clusters and draws the clusters that face away from the center of the section first,
+// they are the most likely to occlude the rest (Sander et al. style overdraw ordering)
+static void SortFaceClustersForOverdraw(const FRawMesh& RawMesh, TArray<int32>& Faces)
+{
+	const int32 ClusterSize = 64;
+
+	auto Corner = [&RawMesh](const int32 Face, const int32 k) { return RawMesh.VertexPositions[RawMesh.WedgeIndices[(Face * 3) + k]]; };
+
+	FVector SectionCenter = FVector::ZeroVector;
+	for (const int32 Face : Faces)
+	{
+		SectionCenter += (Corner(Face, 0) + Corner(Face, 1) + Corner(Face, 2)) / 3.f;
+	}
+	SectionCenter /= FMath::Max(1, Faces.Num());
+
+	struct FCluster
+	{
+		int32 First;
+		int32 Num;
+		float Potential;
+	};
+
+	TArray<FCluster> Clusters;
+	for (int32 First = 0; First < Faces.Num(); First += ClusterSize)
+	{
+		FCluster& Cluster = Clusters.AddDefaulted_GetRef();
+		Cluster.First = First;
+		Cluster.Num = FMath::Min(ClusterSize, Faces.Num() - First);
+
+		FVector Center = FVector::ZeroVector;
+		FVector Normal = FVector::ZeroVector;
+		for (int32 i = First; i < First + Cluster.Num; i++)
+		{
+			const FVector P0 = Corner(Faces[i], 0);
+			const FVector P1 = Corner(Faces[i], 1);
+			const FVector P2 = Corner(Faces[i], 2);
+			Center += (P0 + P1 + P2) / 3.f;
+			// Same winding as the tangent basis of the mesh build, area weighted
+			Normal += (P1 - P2) ^ (P0 - P2);
+		}
+		Center /= Cluster.Num;
+
+		Cluster.Potential = FVector::DotProduct(Center - SectionCenter, Normal.GetSafeNormal());
+	}
+
+	Clusters.StableSort([](const FCluster& A, const FCluster& B) { return A.Potential > B.Potential; });
+
+	TArray<int32> Sorted;
+	Sorted.Reserve(Faces.Num());
+	for (const FCluster& Cluster : Clusters)
+	{
+		Sorted.Append(&Faces[Cluster.First], Cluster.Num);
+	}
+	Faces = MoveTemp(Sorted);
+}
+
+// Reorders the faces of every section for the post transform cache (Forsyth) and optionally for overdraw, then the positions
+// in first use order. Wedge data moves with its face so UVs and colors stay on their verts, sections keep their order
+static void OptimizeRawMeshOrder(FRawMesh& RawMesh, const bool bVertexCache, const bool bOverdraw)
+{
+	const int32 NumFaces = RawMesh.FaceMaterialIndices.Num();
+	if ((NumFaces == 0) || (RawMesh.WedgeIndices.Num() != NumFaces * 3)) return;
+
+	IMeshUtilities& MeshUtilities = FModuleManager::Get().LoadModuleChecked<IMeshUtilities>("MeshUtilities");
+
+	TArray<int32> SectionMaterials;
+	TArray<TArray<int32>> SectionFaces;
+	for (int32 Face = 0; Face < NumFaces; Face++)
+	{
+		int32 Section = SectionMaterials.Find(RawMesh.FaceMaterialIndices[Face]);
+		if (Section == INDEX_NONE)
+		{
+			Section = SectionMaterials.Add(RawMesh.FaceMaterialIndices[Face]);
+			SectionFaces.AddDefaulted();
+		}
+		SectionFaces[Section].Add(Face);
+	}
+
+	// Faces are matched back to the reordered triangles by their sorted corners
+	auto FaceKey = [](uint32 A, uint32 B, uint32 C)
+	{
+		if (A > B) Swap(A, B);
+		if (B > C) Swap(B, C);
+		if (A > B) Swap(A, B);
+		return FIntVector(A, B, C);
+	};
+
+	TArray<int32> NewFaceOrder;
+	NewFaceOrder.Reserve(NumFaces);
+
+	for (TArray<int32>& Faces : SectionFaces)
+	{
+		if (bVertexCache)
+		{
+			TArray<uint32> Indices;
+			Indices.Reserve(Faces.Num() * 3);
+			TMap<FIntVector, TArray<int32>> FacesByKey;
+			for (const int32 Face : Faces)
+			{
+				const uint32* Corners = &RawMesh.WedgeIndices[Face * 3];
+				Indices.Append(Corners, 3);
+				FacesByKey.FindOrAdd(FaceKey(Corners[0], Corners[1], Corners[2])).Add(Face);
+			}
+
+			MeshUtilities.CacheOptimizeIndexBuffer(Indices);
+
+			TArray<int32> Optimized;
+			Optimized.Reserve(Faces.Num());
+			for (int32 i = 0; i + 2 < Indices.Num(); i += 3)
+			{
+				TArray<int32>* Matches = FacesByKey.Find(FaceKey(Indices[i], Indices[i + 1], Indices[i + 2]));
+				if (Matches && Matches->Num()) Optimized.Add(Matches->Pop(false));
+			}
+
+			// Keep the source order if the optimizer dropped or changed triangles
+			if (Optimized.Num() == Faces.Num()) Faces = MoveTemp(Optimized);
+		}
+
+		if (bOverdraw)
+		{
+			SortFaceClustersForOverdraw(RawMesh, Faces);
+		}
+
+		NewFaceOrder.Append(Faces);
+	}
+
+	PermuteRawMeshArray(RawMesh.FaceMaterialIndices, NewFaceOrder, 1);
+	PermuteRawMeshArray(RawMesh.FaceSmoothingMasks, NewFaceOrder, 1);
+	PermuteRawMeshArray(RawMesh.WedgeIndices, NewFaceOrder, 3);
+	PermuteRawMeshArray(RawMesh.WedgeTangentX, NewFaceOrder, 3);
+	PermuteRawMeshArray(RawMesh.WedgeTangentY, NewFaceOrder, 3);
+	PermuteRawMeshArray(RawMesh.WedgeTangentZ, NewFaceOrder, 3);
+	PermuteRawMeshArray(RawMesh.WedgeColors, NewFaceOrder, 3);
+	for (int32 TexCoordIndex = 0; TexCoordIndex < MAX_MESH_TEXTURE_COORDS; TexCoordIndex++)
+	{
+		PermuteRawMeshArray(RawMesh.WedgeTexCoords[TexCoordIndex], NewFaceOrder, 3);
+	}
+
+	// Positions in first use order, unused ones keep their order at the end
+	TArray<int32> PositionRemap;
+	PositionRemap.Init(INDEX_NONE, RawMesh.VertexPositions.Num());
+	TArray<FVector> NewPositions;
+	NewPositions.Reserve(RawMesh.VertexPositions.Num());
+	for (uint32& Index : RawMesh.WedgeIndices)
+	{
+		if (PositionRemap[Index] == INDEX_NONE) PositionRemap[Index] = NewPositions.Add(RawMesh.VertexPositions[Index]);
+		Index = PositionRemap[Index];
+	}
+	for (int32 i = 0; i < PositionRemap.Num(); i++)
+	{
+		if (PositionRemap[i] == INDEX_NONE) NewPositions.Add(RawMesh.VertexPositions[i]);
+	}
+	RawMesh.VertexPositions = MoveTemp(NewPositions);
+}
+
+UStaticMesh* FVertexAnimUtils::ConvertMeshesToStaticMesh(const TArray<UMeshComponent*>& InMeshComponents, const FTransform& InRootTransform, const FString& InPackageName,
+	const FVATStaticMeshChannels* InVATChannels, FVATMeshOrderSettings* InOutOrderSettings)
 {
 	UStaticMesh* StaticMesh = nullptr;
 
@@ -500,6 +736,12 @@ UStaticMesh* FVertexAnimUtils::ConvertMeshesToStaticMesh(const TArray<UMeshCompo
 			}
 		}
 
+		// Before the scrub so the VAT channels count as in use and the lightmap UVs go after them
+		if (InVATChannels)
+		{
+			VATChannelsToRawMeshes(*InVATChannels, RawMeshTrackers, RawMeshes);
+		}
+
 		uint32 MaxInUseTextureCoordinate = 0;
 
 		// scrub invalid vert color & tex coord data
@@ -525,6 +767,28 @@ UStaticMesh* FVertexAnimUtils::ConvertMeshesToStaticMesh(const TArray<UMeshCompo
 			}
 		}
 
+		// Wedge data is complete by now, reorder before the source models are saved
+		if (InOutOrderSettings)
+		{
+			InOutOrderSettings->SourceACMRBefore.Reset();
+			InOutOrderSettings->SourceACMRAfter.Reset();
+
+			for (FRawMesh& RawMesh : RawMeshes)
+			{
+				// Skipped LODs keep their slot so the arrays stay indexed by LOD
+				if (!RawMesh.IsValidOrFixable())
+				{
+					InOutOrderSettings->SourceACMRBefore.Add(FVATMeshOrderSettings::SkippedLOD);
+					InOutOrderSettings->SourceACMRAfter.Add(FVATMeshOrderSettings::SkippedLOD);
+					continue;
+				}
+
+				InOutOrderSettings->SourceACMRBefore.Add(CalcACMR(RawMesh.WedgeIndices));
+				OptimizeRawMeshOrder(RawMesh, InOutOrderSettings->bVertexCache, InOutOrderSettings->bOverdraw);
+				InOutOrderSettings->SourceACMRAfter.Add(CalcACMR(RawMesh.WedgeIndices));
+			}
+		}
+
 		// Check if we got some valid data.
 		bool bValidData = false;
 		for (FRawMesh& RawMesh : RawMeshes)
@@ -604,6 +868,25 @@ UStaticMesh* FVertexAnimUtils::ConvertMeshesToStaticMesh(const TArray<UMeshCompo
 			StaticMesh->Build(false);
 			StaticMesh->PostEditChange();
 
+			if (InOutOrderSettings && StaticMesh->RenderData)
+			{
+				// Skipped raw meshes have no built LOD, they get the sentinel so the array is indexed like the source ones
+				InOutOrderSettings->BuiltACMR.Reset();
+				int32 BuiltLOD = 0;
+				for (const FRawMesh& RawMesh : RawMeshes)
+				{
+					if (!RawMesh.IsValidOrFixable() || !StaticMesh->RenderData->LODResources.IsValidIndex(BuiltLOD))
+					{
+						InOutOrderSettings->BuiltACMR.Add(FVATMeshOrderSettings::SkippedLOD);
+						continue;
+					}
+
+					TArray<uint32> Indices;
+					StaticMesh->RenderData->LODResources[BuiltLOD++].IndexBuffer.GetCopy(Indices);
+					InOutOrderSettings->BuiltACMR.Add(CalcACMR(Indices));
+				}
+			}
+
 			StaticMesh->MarkPackageDirty();
 
 			// Notify asset registry of new asset
@@ -748,6 +1031,7 @@ void FVertexAnimUtils::VATColorsToStaticMeshLODs(UStaticMesh* StaticMesh, const
 
 void SPickAssetDialog::Construct(const FArguments& InArgs)
 {
+	SkeletonPath = InArgs._Skeleton ? InArgs._Skeleton->GetPathName() : FString();
 
 	FContentBrowserModule& ContentBrowserModule = FModuleManager::LoadModuleChecked<FContentBrowserModule>("ContentBrowser");
 
@@ -1104,6 +1388,10 @@ FReply SPickAssetDialog::OnButtonClick(EAppReturnType::Type ButtonID)
 			FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("AnimsInProfileWith0NumFrames", "Selected Profile has anim with Num Frames less than 1"));
 			return FReply::Unhandled();
 			break;
+		case 9: // Hybrid bake without bone anims or vertex selection
+			FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("InvalidHybridBake", "Selected Profile is a Hybrid Bake without Bone Anims or without Hybrid Material Slots / Bones"));
+			return FReply::Unhandled();
+			break;
 		default:
 			break;
 		};
@@ -1200,24 +1488,13 @@ UVertexAnimProfile * SPickAssetDialog::GetSelectedProfile() const
 {
 	TArray<FAssetData> SelectionArray = GetCurrentSelectionDelegate_Profile.Execute();
 
-	if (SelectionArray.Num() > 0)
+	// Only the picked profile gets loaded
+	for (const FAssetData& AssetData : SelectionArray)
 	{
-		TArray <UVertexAnimProfile*> StoredProfiles;
-
-		for (int i = 0; i < SelectionArray.Num(); i++)
+		if (UVertexAnimProfile* Profile = Cast <UVertexAnimProfile>(AssetData.GetAsset()))
 		{
-			SelectionArray[i].GetPackage()->FullyLoad();
-			if (SelectionArray[i].IsAssetLoaded())
-			{
-				UVertexAnimProfile* NewSequence = Cast <UVertexAnimProfile>(SelectionArray[i].GetAsset());
-				if (NewSequence)
-				{
-					StoredProfiles.Add(NewSequence);
-				}
-			}
+			return Profile;
 		}
-
-		return StoredProfiles[0];
 	}
 
 	return NULL;
@@ -1227,74 +1504,39 @@ UVertexAnimProfile * SPickAssetDialog::GetSelectedProfile() const
 
 bool SPickAssetDialog::Filter(const FAssetData & AssetData)
 {
-	if (!AssetData.IsAssetLoaded())
-	{
-		AssetData.GetPackage()->FullyLoad();
-	}
+	// Registry tags only, the picker never loads profiles. Untagged profiles (saved before the tags) are always shown
+	FString ProfileSkeleton;
+	if (SkeletonPath.IsEmpty() || !AssetData.GetTagValue(TEXT("Skeleton"), ProfileSkeleton) || ProfileSkeleton.IsEmpty()) return false;
 
-	return false;
+	return ProfileSkeleton != SkeletonPath;
 }
 
 int32 SPickAssetDialog::ValidateProfile() const
 {
-	UVertexAnimProfile* Profile = GetSelectedProfile();
-	if (Profile != NULL)
-	{
-		// Invalid Offsets or Normals Texture
-		if ((!Profile->AutoSize) && (Profile->OverrideSize_Vert.GetMax() < 8)) return 4;
-		// Profile has not Anims
-		if ((Profile->Anims_Vert.Num() == 0) && (Profile->Anims_Bone.Num() == 0)) return 5;
-		
-		
-		USkeleton* Skeleton = NULL;
-		if (Profile->Anims_Vert.Num())
-			if (Profile->Anims_Vert[0].SequenceRef != NULL) Skeleton = Profile->Anims_Vert[0].SequenceRef->GetSkeleton();
-		if (Profile->Anims_Bone.Num())
-			if (Profile->Anims_Bone[0].SequenceRef != NULL) Skeleton = Profile->Anims_Bone[0].SequenceRef->GetSkeleton();
+	TArray<FAssetData> SelectionArray = GetCurrentSelectionDelegate_Profile.Execute();
 
-		{
-			for (int32 i = 0; i < Profile->Anims_Vert.Num(); i++)
-			{
-				// Invalid Sequence Ref
-				if (Profile->Anims_Vert[i].SequenceRef == NULL) return 6;
-				
-				if (Profile->Anims_Vert[i].SequenceRef->GetSkeleton() != Skeleton)
-				{
-					// Anims have different Skeletons
-					return 7;
-				}
-				if ((Profile->Anims_Vert[i].NumFrames < 1))
-				{
-					// Anim has Num Frames less than 1
-					return 8;
-				}
-			}
-		}
-		{
-			for (int32 i = 0; i < Profile->Anims_Bone.Num(); i++)
-			{
-				// Invalid Sequence Ref
-				if (Profile->Anims_Bone[i].SequenceRef == NULL) return 6;
+	// NULL PROFILE
+	if (SelectionArray.Num() == 0) return 1;
 
-				if (Profile->Anims_Bone[i].SequenceRef->GetSkeleton() != Skeleton)
-				{
-					// Anims have different Skeletons
-					return 7;
-				}
-				if ((Profile->Anims_Bone[i].NumFrames < 1))
-				{
-					// Anim has Num Frames less than 1
-					return 8;
-				}
-			}
-		}
+	// Loaded profiles may have unsaved edits, so the tags are only trusted for unloaded ones
+	FVAProfileSummary Summary;
+	if (SelectionArray[0].IsAssetLoaded() || !Summary.FromAssetData(SelectionArray[0]))
+	{
+		UVertexAnimProfile* Profile = GetSelectedProfile();
+		if (Profile == NULL) return 1;
 
-		//Profile->LODInSkeletalMesh;
-		return 0;
+		Summary = Profile->CalcSummary();
 	}
 
-	// NULL PROFILE
-	return 1;
+	// Invalid Offsets or Normals Texture
+	if ((!Summary.AutoSize) && (Summary.OverrideSizeMax_Vert < 8)) return 4;
+	// Profile has not Anims
+	if ((Summary.NumAnims_Vert == 0) && (Summary.NumAnims_Bone == 0)) return 5;
+	// Hybrid bake without bone anims or vertex selection
+	if (Summary.HybridBake && ((Summary.NumAnims_Bone == 0) || !Summary.HybridSelection)) return 9;
+
+	// Invalid Sequence Ref, Anims have different Skeletons or Anim has Num Frames less than 1
+	return Summary.AnimError;
 }
 
 
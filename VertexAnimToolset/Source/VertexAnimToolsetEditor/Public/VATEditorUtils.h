@@ -15,6 +15,9 @@
 class UDebugSkelMeshComponent;
 class UTextureRenderTarget2D;
 class UAnimSequence;
+class UVertexAnimProfile;
+class USkeletalMesh;
+struct FVAProfileEstimate;
 
 class FPrimitiveSceneProxy;
 class FColorVertexBuffer;
@@ -30,7 +33,19 @@ public:
     static float PackBits(const uint32& bit);
     static int UnPackBits(const float bit);
 
+    // Returns once the bake started, the pose gather then drives the Persona preview scene one frame per editor tick, encoding runs
+    // on the thread pool and the static mesh and textures are written on the game thread once it is done. A notification shows
+    // the progress, cancelling from it restores the profile and leaves existing assets untouched
     static void DoBakeProcess(UDebugSkelMeshComponent* PreviewComponent);
+    // Cancels the running bake, if any
+    static void CancelBake();
+
+    // Times the bake stages on procedurally generated skinned meshes over a sweep of vert, bone, LOD and frame counts,
+    // writes CSV and JSON reports to Saved/VertexAnimToolset
+    static void RunBakeBenchmark(const bool bQuick, FOutputDevice& Ar);
+
+    // Runs only the layout stages of the bake for the mesh, no posing or encoding
+    static FVAProfileEstimate EstimateProfile(const UVertexAnimProfile* Profile, const USkeletalMesh* Mesh);
     
     static void SkelPivotPos(USkeletalMesh* Skel, TArray <FVector>& VectorData);
     static void SkelOrigin(USkeletalMesh* Skel, TArray <FVector>& VectorData);
@@ -44,5 +44,7 @@ protected:
 	FDelegateHandle ModuleLoadedDelegateHandle;
 	//FDelegateHandle AnimationEditorExtenderHandle;
 	FDelegateHandle SkeletalMeshEditorExtenderHandle;
+
+	IConsoleObject* BakeBenchmarkCommand = NULL;
 private:
 };
@@ -28,6 +28,45 @@ class FSkeletalMeshLODRenderData;
 class FSkinWeightVertexBuffer;
 struct FActiveMorphTarget;
 class UVertexAnimProfile;
+class USkeleton;
+
+// VAT UV channels and vertex colors, per LOD and per skinned vertex, written into the source models before the mesh is built
+struct FVATStaticMeshChannels
+{
+	struct FUVChannel
+	{
+		int32 Channel = INDEX_NONE;
+		const TArray <TArray <FVector2D>>* UVs = NULL;
+	};
+
+	TArray <FUVChannel> UVChannels;
+	const TArray <TArray <FColor>>* Colors = NULL;
+
+	void AddUVs(const int32 Channel, const TArray <TArray <FVector2D>>& UVs)
+	{
+		if (Channel < 0) return;
+
+		FUVChannel& UVChannel = UVChannels.AddDefaulted_GetRef();
+		UVChannel.Channel = Channel;
+		UVChannel.UVs = &UVs;
+	}
+};
+
+// Triangle and vertex order optimization of the source models, ACMR (post transform cache misses per triangle) is filled in per LOD.
+// Source ACMR counts the raw mesh positions, built ACMR the render verts of the built mesh. The engine build cache optimizes
+// the index buffers again, so the source order does not reach the render data and only built ACMR is what renders
+struct FVATMeshOrderSettings
+{
+	bool bVertexCache = false;
+	bool bOverdraw = false;
+
+	// ACMR of the LODs whose raw mesh is not valid
+	static constexpr float SkippedLOD = -1.f;
+
+	TArray <float> SourceACMRBefore;
+	TArray <float> SourceACMRAfter;
+	TArray <float> BuiltACMR;
+};
 
 // Abstract class holding helper functions to be used in the baking process
 class FVertexAnimUtils
@@ -53,10 +92,14 @@ public:
 	 * @param	InMeshComponents		The mesh components we want to convert
 	 * @param	InRootTransform			The transform of the root of the mesh we want to output
 	 * @param	InPackageName			The package name to create the static mesh in. If this is empty then a dialog will be displayed to pick the mesh.
+	 * @param	InVATChannels			Optional VAT UVs and colors added to the mesh, it is still only built once
+	 * @param	InOutOrderSettings		Optional triangle order optimization of every section, the VAT channels follow the reordered wedges
 	 * @return a new static mesh (specified by the user)
 	 */
-	static UStaticMesh* ConvertMeshesToStaticMesh(const TArray<UMeshComponent*>& InMeshComponents, const FTransform& InRootTransform = FTransform::Identity, const FString& InPackageName = FString());
+	static UStaticMesh* ConvertMeshesToStaticMesh(const TArray<UMeshComponent*>& InMeshComponents, const FTransform& InRootTransform = FTransform::Identity, const FString& InPackageName = FString(),
+		const FVATStaticMeshChannels* InVATChannels = NULL, FVATMeshOrderSettings* InOutOrderSettings = NULL);
 
+	// Both rebuild the static mesh, prefer passing FVATStaticMeshChannels to ConvertMeshesToStaticMesh
 	static void VATUVsToStaticMeshLODs(UStaticMesh* StaticMesh, const int32 UVChannel, const TArray <TArray <FVector2D>>& UVs);
 	static void VATColorsToStaticMeshLODs(UStaticMesh* StaticMesh, const TArray <TArray <FColor>>& Colors);
 
@@ -69,10 +112,13 @@ class SPickAssetDialog : public SWindow
 {
 public:
 	SLATE_BEGIN_ARGS(SPickAssetDialog)
+		: _Skeleton(NULL)
 	{
 	}
 	SLATE_ARGUMENT(FText, Title)
 		SLATE_ARGUMENT(FText, DefaultAssetPath)
+		// Hides the profiles of other skeletons
+		SLATE_ARGUMENT(USkeleton*, Skeleton)
 		SLATE_END_ARGS()
 
 		VERTEXANIMTOOLSETEDITOR_API SPickAssetDialog()
@@ -124,6 +170,8 @@ protected:
 	FText AssetName;
 
 	bool bOnlyCreateStaticMesh = false;
+
+	FString SkeletonPath;
 };
 
 #undef LOCTEXT_NAMESPACE
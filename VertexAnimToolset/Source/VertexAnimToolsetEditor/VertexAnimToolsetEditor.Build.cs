@@ -61,6 +61,8 @@ public class VertexAnimToolsetEditor : ModuleRules
                 "AnimationEditor",
                 "SkeletalMeshEditor",
 				"MeshUtilities",
+				"Json",
+				"PropertyEditor",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);